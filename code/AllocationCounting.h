@@ -0,0 +1,90 @@
+#ifndef DNest4_AllocationCounting
+#define DNest4_AllocationCounting
+
+#include <cstdlib>
+#include <new>
+#include "ModelBenchmark.h"
+
+/*
+* Replaces the global operator new and delete with versions that count
+* each thread's allocations, for benchmark_model() (see
+* ModelBenchmark.h). Include this in exactly one source file of a
+* program, and never in a library: it affects every allocation the
+* program makes.
+*/
+
+namespace DNest4
+{
+namespace
+{
+
+thread_local unsigned long long int num_allocations = 0;
+
+unsigned long long int get_num_allocations()
+{
+	return num_allocations;
+}
+
+void* counted_allocation(std::size_t size)
+{
+	++num_allocations;
+	void* result = std::malloc((size > 0)?(size):(1));
+	if(result == nullptr)
+		throw std::bad_alloc();
+	return result;
+}
+
+// Point count_allocations at this file's counter before main() starts
+struct InstallAllocationCounter
+{
+	InstallAllocationCounter()
+	{ count_allocations = get_num_allocations; }
+} install_allocation_counter;
+
+} // namespace
+} // namespace DNest4
+
+void* operator new(std::size_t size)
+{
+	return DNest4::counted_allocation(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return DNest4::counted_allocation(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	++DNest4::num_allocations;
+	return std::malloc((size > 0)?(size):(1));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	++DNest4::num_allocations;
+	return std::malloc((size > 0)?(size):(1));
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+#endif
+
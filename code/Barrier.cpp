@@ -1,4 +1,6 @@
 #include "Barrier.h"
+#include "ThreadPool.h"
+#include <chrono>
 
 using namespace DNest4;
 
@@ -10,7 +12,7 @@ Barrier::Barrier(unsigned int count)
 
 }
 
-void Barrier::wait()
+void Barrier::wait(ThreadPool* pool)
 {
 	unsigned int gen = generation;
 	std::unique_lock<std::mutex> lock{the_mutex};
@@ -20,7 +22,18 @@ void Barrier::wait()
 		count = threshold;
 		cond.notify_all();
 	}
-	else
+	else if(pool == nullptr)
 		cond.wait(lock, [this, gen] { return gen != generation; });
+	else
+	{
+		while(gen == generation)
+		{
+			lock.unlock();
+			bool ran = pool->run_pending_task();
+			lock.lock();
+			if(!ran && gen == generation)
+				cond.wait_for(lock, std::chrono::microseconds(200));
+		}
+	}
 }
 
@@ -7,6 +7,8 @@
 namespace DNest4
 {
 
+class ThreadPool;
+
 /*
 * Barrier class based on an answer at
 * http://stackoverflow.com/questions/24465533/implementing-boostbarrier-in-c11
@@ -25,8 +27,9 @@ class Barrier
 		// Constructor: initialise count
 		explicit Barrier(unsigned int count);
 
-		// Wait method
-		void wait();
+		// Wait method. Threads waiting for the others run tasks queued
+		// on 'pool', if given.
+		void wait(ThreadPool* pool=nullptr);
 };
 
 } // namespace DNest4
@@ -0,0 +1,75 @@
+#ifndef DNest4_Batch
+#define DNest4_Batch
+
+#include <ostream>
+#include <vector>
+#include "Options.h"
+#include "Sampler.h"
+
+namespace DNest4
+{
+
+/*
+* Runs many small, independent, single-threaded samplers (jobs)
+* concurrently on one shared ThreadPool. Each job has its own
+* options (so its own output files) and its own prototype particle
+* (so its own dataset).
+*/
+template<class ModelType>
+class Batch
+{
+	private:
+		// Number of worker threads shared by all jobs
+		unsigned int num_workers;
+
+		// One sampler per job, and the seed for each
+		std::vector< Sampler<ModelType> > samplers;
+		std::vector<unsigned int> seeds;
+
+		// Whether run() owns SIGTERM (see handle_sigterm())
+		bool owns_sigterm;
+		unsigned int drain_deadline;
+
+		// Wall-clock time (in seconds) of each job and of the whole batch
+		std::vector<double> job_times;
+		double total_time;
+
+		// Initialise and run job 'which' to completion
+		void run_job(unsigned int which, unsigned int thin);
+
+	public:
+		// Constructor: specify the size of the pool
+		explicit Batch(unsigned int num_workers);
+
+		// Add a job and return its index. Jobs must have max_num_saves > 0.
+		size_t add_job(const ModelType& prototype, const Options& options,
+						double compression, unsigned int seed,
+						bool save_to_disk=true, bool adaptive=false);
+
+		// Install the drain handler (SignalHandling.h) while running, so
+		// that SIGTERM checkpoints and stops every job. Off by default,
+		// leaving SIGTERM to the program embedding the batch.
+		void handle_sigterm(unsigned int deadline=25);
+
+		// Run every job
+		void run(unsigned int thin=1);
+
+		// Getters
+		size_t size() const
+		{ return samplers.size(); }
+		const Sampler<ModelType>& get_sampler(size_t which) const
+		{ return samplers[which]; }
+		double get_job_time(size_t which) const
+		{ return job_times[which]; }
+		double get_total_time() const
+		{ return total_time; }
+
+		// Print MCMC steps per second of each job and of the batch
+		void print_throughput(std::ostream& out) const;
+};
+
+} // namespace DNest4
+
+#include "BatchImpl.h"
+#endif
+
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include "SignalHandling.h"
+#include "ThreadPool.h"
+
+namespace DNest4
+{
+
+template<class ModelType>
+Batch<ModelType>::Batch(unsigned int num_workers)
+:num_workers(num_workers)
+,owns_sigterm(false)
+,drain_deadline(25)
+,total_time(0.0)
+{
+	assert(num_workers >= 1);
+}
+
+template<class ModelType>
+size_t Batch<ModelType>::add_job(const ModelType& prototype,
+									const Options& options,
+									double compression, unsigned int seed,
+									bool save_to_disk, bool adaptive)
+{
+	// Jobs share the pool, so each must finish
+	if(options.max_num_saves == 0)
+		throw std::runtime_error("batch jobs need a finite max_num_saves.");
+
+	samplers.push_back(Sampler<ModelType>(1, compression, options,
+										save_to_disk, adaptive, prototype));
+	seeds.push_back(seed);
+	job_times.push_back(0.0);
+	return samplers.size() - 1;
+}
+
+template<class ModelType>
+void Batch<ModelType>::run_job(unsigned int which, unsigned int thin)
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	samplers[which].initialise(seeds[which]);
+	samplers[which].run_on_this_thread(thin);
+
+	std::chrono::duration<double> elapsed =
+						std::chrono::steady_clock::now() - start_time;
+	job_times[which] = elapsed.count();
+}
+
+template<class ModelType>
+void Batch<ModelType>::handle_sigterm(unsigned int deadline)
+{
+	owns_sigterm = true;
+	drain_deadline = deadline;
+}
+
+template<class ModelType>
+void Batch<ModelType>::run(unsigned int thin)
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	if(owns_sigterm)
+		install_drain_handler(drain_deadline);
+
+	ThreadPool pool(num_workers);
+	for(size_t i=0; i<samplers.size(); ++i)
+		pool.submit(std::bind(&Batch<ModelType>::run_job, this, i, thin));
+
+	// Only the workers run jobs, so the batch uses num_workers threads
+	pool.wait(false);
+
+	// Jobs run after a drain checkpoint at once; the drain is served now
+	if(drain_requested())
+		reset_drain();
+
+	std::chrono::duration<double> elapsed =
+						std::chrono::steady_clock::now() - start_time;
+	total_time = elapsed.count();
+}
+
+template<class ModelType>
+void Batch<ModelType>::print_throughput(std::ostream& out) const
+{
+	unsigned long long int total_steps = 0;
+	for(size_t i=0; i<samplers.size(); ++i)
+	{
+		unsigned long long int steps = samplers[i].get_count_mcmc_steps();
+		total_steps += steps;
+
+		out<<"# Job "<<i<<": "<<steps<<" MCMC steps in "<<job_times[i];
+		out<<" s ("<<steps/job_times[i]<<" steps/s)."<<std::endl;
+	}
+
+	out<<"# Batch: "<<samplers.size()<<" jobs, "<<total_steps;
+	out<<" MCMC steps in "<<total_time<<" s on "<<num_workers<<" threads (";
+	out<<total_steps/total_time<<" steps/s, ";
+	out<<samplers.size()/total_time<<" jobs/s)."<<std::endl;
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,31 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "DNest4/code/DNest4.h"
+#include "DNest4/code/AllocationCounting.h"
+#include "Data.h"
+#include "StraightLine.h"
+
+using namespace DNest4;
+
+/*
+* What each of StraightLine's methods costs with 10000 data points,
+* measured with benchmark_model() and no Sampler.
+*/
+int main()
+{
+	std::vector<double> x(10000), y(10000);
+	RNG rng(0);
+	for(size_t i=0; i<x.size(); ++i)
+	{
+		x[i] = 10.*i/x.size();
+		y[i] = 3.*x[i] + 1. + rng.randn();
+	}
+
+	StraightLine line(std::make_shared<const Data>(x, y));
+	ModelCost cost = benchmark_model(line, 10000);
+	cost.print(std::cout);
+
+	return 0;
+}
+
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "DNest4/code/DNest4.h"
+
+using namespace DNest4;
+
+/*
+* Time single-threaded runs of a model whose likelihood costs almost
+* nothing, with the levels updated in place and through a per-round copy.
+* The profiler times the copying and merging of the levels directly,
+* which is the work that updating in place skips; whole-run times are
+* shown too, but with a model this cheap they are mostly noise.
+*/
+
+// A Gaussian likelihood with a uniform prior on one parameter
+class Cheap
+{
+	private:
+		double x, x_proposed;
+
+	public:
+		Cheap() :x(0.), x_proposed(0.) { }
+
+		void from_prior(size_t i)
+		{ RNG rng(i); x = -10. + 20.*rng.rand(); x_proposed = x; }
+
+		double perturb(RNG& rng)
+		{
+			x_proposed = x + 20.*rng.randh();
+			wrap(x_proposed, -10., 10.);
+			return 0.;
+		}
+
+		void accept_perturbation()
+		{ x = x_proposed; }
+
+		double log_likelihood() const
+		{ return -0.5*x*x; }
+
+		double proposal_log_likelihood() const
+		{ return -0.5*x_proposed*x_proposed; }
+
+		void print(std::ostream& out) const { out<<x<<' '; }
+		void read(std::istream& in) { in>>x; }
+		void print_internal(std::ostream& out) const { out<<x_proposed<<' '; }
+		void read_internal(std::istream& in) { in>>x_proposed; }
+		std::string description() const { return "x"; }
+};
+
+// What one run measured
+struct Timing
+{
+	double total;		// Whole run (s)
+	double merge;		// Copying and merging the levels, per round (us)
+};
+
+// Run 'num_steps' MCMC steps, returning the timings and the levels
+Timing run(unsigned int thread_steps, unsigned int num_steps, bool in_place,
+			std::string& levels)
+{
+	Options options(1, 1000, 10000, thread_steps, 30, 10., 100.,
+					num_steps/10000, false);
+
+	Sampler<Cheap> sampler(1, exp(1.), options, false, false);
+	sampler.get_logger().set_level(LogLevel::off);
+	sampler.set_levels_in_place(in_place);
+	sampler.set_profiling(true);
+	sampler.initialise(0);
+	auto start = std::chrono::steady_clock::now();
+	sampler.run_on_this_thread();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	// These are written even without save_to_disk
+	std::remove(options.checkpoint_file.c_str());
+	std::remove(options.best_particle_file.c_str());
+	std::remove(options.best_likelihood_file.c_str());
+
+	std::stringstream s;
+	for(const auto& level: sampler.get_levels())
+		level.print(s);
+	levels = s.str();
+
+	double rounds = (double)num_steps/thread_steps;
+	const PhaseCounters& counters = sampler.get_phase_counters()[0];
+	return {elapsed.count(), 1E6*counters.get_seconds(Phase::level_merge)/rounds};
+}
+
+// Mean and standard deviation, as "mean +- sd"
+std::string summary(const std::vector<double>& x)
+{
+	double mean = 0., var = 0.;
+	for(double xx: x)
+		mean += xx/x.size();
+	for(double xx: x)
+		var += pow(xx - mean, 2)/(x.size() - 1);
+
+	std::stringstream s;
+	s << std::fixed << std::setprecision(3) << mean << " +- " << sqrt(var);
+	return s.str();
+}
+
+int main()
+{
+	const unsigned int num_steps = 2000000;
+	const int repetitions = 5;
+
+	std::cout << "# " << num_steps << " MCMC steps on one thread, ";
+	std::cout << repetitions << " runs each (mean +- sd)." << std::endl;
+	std::cout << "# thread_steps, copy and merge per round with copies (us), ";
+	std::cout << "the same in place (us), run time with copies (s), ";
+	std::cout << "run time in place (s), same output" << std::endl;
+	for(unsigned int thread_steps: {1, 10, 100})
+	{
+		std::string levels_copied, levels_in_place;
+		std::vector<double> merge_copied, merge_in_place;
+		std::vector<double> total_copied, total_in_place;
+		for(int i=0; i<repetitions; ++i)
+		{
+			Timing t = run(thread_steps, num_steps, false, levels_copied);
+			merge_copied.push_back(t.merge);
+			total_copied.push_back(t.total);
+
+			t = run(thread_steps, num_steps, true, levels_in_place);
+			merge_in_place.push_back(t.merge);
+			total_in_place.push_back(t.total);
+		}
+
+		std::cout << thread_steps << ", " << summary(merge_copied) << ", ";
+		std::cout << summary(merge_in_place) << ", ";
+		std::cout << summary(total_copied) << ", ";
+		std::cout << summary(total_in_place) << ", ";
+		std::cout << ((levels_copied == levels_in_place)?("yes"):("no"));
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
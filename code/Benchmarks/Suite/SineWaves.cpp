@@ -0,0 +1,111 @@
+#include "SineWaves.h"
+#include <cmath>
+#include <vector>
+
+using namespace DNest4;
+
+SineWaves::SineWaves()
+:waves(2, 10, false, ClassicMassInf1D(log(0.5), log(50.), 0.1, 10.))
+,waves_proposed(waves)
+{
+
+}
+
+SineWaves::SineWaves(const std::shared_ptr<const Data>& data)
+:SineWaves()
+{
+	this->data = data;
+}
+
+std::shared_ptr<const Data> SineWaves::make_data(size_t n)
+{
+	RNG rng(0);
+	std::vector<double> t(n), y(n);
+	for(size_t i=0; i<n; ++i)
+	{
+		t[i] = 0.1*i;
+		y[i] = 2.*sin(2.*M_PI*t[i]/5.) + sin(2.*M_PI*t[i]/1.3) + rng.randn();
+	}
+	return std::make_shared<const Data>(t, y);
+}
+
+void SineWaves::calculate_mu(const RJObject<ClassicMassInf1D>& w,
+							std::valarray<double>& result) const
+{
+	const auto& t = data->get_x();
+	result.resize(t.size());
+	result = 0.;
+	for(const auto& wave: w.get_components())
+		result += wave[1]*sin(2.*M_PI*t/exp(wave[0]));
+}
+
+double SineWaves::log_likelihood_of(const std::valarray<double>& m) const
+{
+	const auto& y = data->get_y();
+	double total = -0.5*y.size()*log(2.*M_PI);
+	for(size_t i=0; i<y.size(); ++i)
+		total += -0.5*pow(y[i] - m[i], 2);
+	return total;
+}
+
+void SineWaves::from_prior(size_t i)
+{
+	RNG rng(i);
+	waves.from_prior(rng);
+	waves_proposed = waves;
+	calculate_mu(waves, mu);
+	mu_proposed = mu;
+}
+
+double SineWaves::perturb(RNG& rng)
+{
+	waves_proposed = waves;
+	double log_H = waves_proposed.perturb(rng);
+	calculate_mu(waves_proposed, mu_proposed);
+	return log_H;
+}
+
+void SineWaves::accept_perturbation()
+{
+	waves = waves_proposed;
+	mu = mu_proposed;
+}
+
+double SineWaves::log_likelihood() const
+{
+	return log_likelihood_of(mu);
+}
+
+double SineWaves::proposal_log_likelihood() const
+{
+	return log_likelihood_of(mu_proposed);
+}
+
+void SineWaves::print(std::ostream& out) const
+{
+	waves.print(out);
+}
+
+void SineWaves::read(std::istream& in)
+{
+	waves.read(in);
+	calculate_mu(waves, mu);
+}
+
+void SineWaves::print_internal(std::ostream& out) const
+{
+	waves_proposed.print(out);
+}
+
+void SineWaves::read_internal(std::istream& in)
+{
+	waves_proposed.read(in);
+	calculate_mu(waves_proposed, mu_proposed);
+}
+
+std::string SineWaves::description() const
+{
+	return "num_dimensions, max_num_components, mu, num_components, "
+			"log_periods, amplitudes";
+}
+
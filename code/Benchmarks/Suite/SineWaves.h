@@ -0,0 +1,52 @@
+#ifndef DNest4_Benchmarks_SineWaves
+#define DNest4_Benchmarks_SineWaves
+
+#include "DNest4/code/DNest4.h"
+#include <memory>
+#include <ostream>
+#include <valarray>
+#include "Data.h"
+
+/*
+* A trans-dimensional model: an unknown number of sine waves, each with a
+* log-period and an amplitude, fitted to a time series with unit noise.
+* The waves are an RJObject, so its birth and death moves are exercised.
+*/
+class SineWaves
+{
+	private:
+		// The time series (shared between particles)
+		std::shared_ptr<const Data> data;
+
+		DNest4::RJObject<DNest4::ClassicMassInf1D> waves, waves_proposed;
+
+		// Model prediction
+		std::valarray<double> mu, mu_proposed;
+
+		void calculate_mu(const DNest4::RJObject<DNest4::ClassicMassInf1D>& w,
+							std::valarray<double>& result) const;
+		double log_likelihood_of(const std::valarray<double>& m) const;
+
+	public:
+		SineWaves();
+		explicit SineWaves(const std::shared_ptr<const Data>& data);
+
+		// A series of 'n' points made by two waves plus noise
+		static std::shared_ptr<const Data> make_data(size_t n);
+
+		void from_prior(size_t i);
+		double perturb(DNest4::RNG& rng);
+		void accept_perturbation();
+
+		double log_likelihood() const;
+		double proposal_log_likelihood() const;
+
+		void print(std::ostream& out) const;
+		void read(std::istream& in);
+		void print_internal(std::ostream& out) const;
+		void read_internal(std::istream& in);
+		std::string description() const;
+};
+
+#endif
+
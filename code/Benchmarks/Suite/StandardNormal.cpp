@@ -0,0 +1,89 @@
+#include "StandardNormal.h"
+#include <cmath>
+
+using namespace DNest4;
+
+static double log_likelihood_of(const std::vector<double>& x)
+{
+	double total = -0.5*x.size()*log(2.*M_PI);
+	for(double xi: x)
+		total += -0.5*xi*xi;
+	return total;
+}
+
+StandardNormal::StandardNormal(size_t num_dimensions)
+:x(num_dimensions, 0.)
+,x_proposed(num_dimensions, 0.)
+{
+
+}
+
+void StandardNormal::from_prior(size_t i)
+{
+	RNG rng(i);
+	for(double& xi: x)
+		xi = -10. + 20.*rng.rand();
+	x_proposed = x;
+}
+
+double StandardNormal::perturb(RNG& rng)
+{
+	x_proposed = x;
+
+	// Move one coordinate, or sometimes several
+	int reps = 1;
+	if(rng.rand() <= 0.5)
+		reps = (int)pow(x.size(), rng.rand());
+	for(int i=0; i<reps; ++i)
+	{
+		double& xi = x_proposed[rng.rand_int(x.size())];
+		xi += 20.*rng.randh();
+		wrap(xi, -10., 10.);
+	}
+	return 0.;
+}
+
+void StandardNormal::accept_perturbation()
+{
+	x = x_proposed;
+}
+
+double StandardNormal::log_likelihood() const
+{
+	return log_likelihood_of(x);
+}
+
+double StandardNormal::proposal_log_likelihood() const
+{
+	return log_likelihood_of(x_proposed);
+}
+
+void StandardNormal::print(std::ostream& out) const
+{
+	for(double xi: x)
+		out<<xi<<' ';
+}
+
+void StandardNormal::read(std::istream& in)
+{
+	for(double& xi: x)
+		in>>xi;
+}
+
+void StandardNormal::print_internal(std::ostream& out) const
+{
+	for(double xi: x_proposed)
+		out<<xi<<' ';
+}
+
+void StandardNormal::read_internal(std::istream& in)
+{
+	for(double& xi: x_proposed)
+		in>>xi;
+}
+
+std::string StandardNormal::description() const
+{
+	return "x[0], ..., x[" + std::to_string(x.size() - 1) + "]";
+}
+
@@ -0,0 +1,35 @@
+#ifndef DNest4_Benchmarks_StandardNormal
+#define DNest4_Benchmarks_StandardNormal
+
+#include "DNest4/code/DNest4.h"
+#include <ostream>
+#include <vector>
+
+/*
+* A standard normal likelihood with a uniform prior on [-10, 10] in each
+* of any number of dimensions. The likelihood costs O(dimensions).
+*/
+class StandardNormal
+{
+	private:
+		std::vector<double> x, x_proposed;
+
+	public:
+		explicit StandardNormal(size_t num_dimensions=2);
+
+		void from_prior(size_t i);
+		double perturb(DNest4::RNG& rng);
+		void accept_perturbation();
+
+		double log_likelihood() const;
+		double proposal_log_likelihood() const;
+
+		void print(std::ostream& out) const;
+		void read(std::istream& in);
+		void print_internal(std::ostream& out) const;
+		void read_internal(std::istream& in);
+		std::string description() const;
+};
+
+#endif
+
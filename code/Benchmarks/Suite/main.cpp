@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DNest4/code/DNest4.h"
+#include "Data.h"
+#include "SineWaves.h"
+#include "StandardNormal.h"
+#include "StraightLine.h"
+
+using namespace DNest4;
+
+/*
+* Fixed-seed workloads for tracking the sampler's speed between versions:
+* Gaussians from 2 to 1000 dimensions, a straight line fitted to a large
+* dataset, and a trans-dimensional (RJObject) model, the last two on 1 to
+* N threads. Each run creates the same number of levels and carries on
+* to a fixed number of saves per thread, so with perfect scaling the steps
+* per second grow in proportion to the threads. The results go to stdout
+* as JSON.
+*
+* Usage: main [max_num_threads]
+*/
+
+// What one run measured
+struct Result
+{
+	std::string workload;
+	std::string parameters;
+	unsigned int num_threads;
+	unsigned long long int steps;
+	unsigned long long int likelihood_evaluations;
+	double seconds;
+	size_t num_levels;
+	double level_creation_seconds;	// NaN if the levels weren't finished
+	double bookkeeping_seconds;
+	unsigned long long int bookkeeping_calls;
+	double checkpoint_seconds;
+	unsigned long long int checkpoint_calls;
+};
+
+// The timeline's start and the end of its last event, or of the last
+// event called 'name' in the first buffer. False if events were dropped.
+bool trace_span(const std::vector<TraceBuffer>& buffers, const char* name,
+				double& seconds)
+{
+	long long int begin = std::numeric_limits<long long int>::max();
+	long long int end = std::numeric_limits<long long int>::min();
+	for(size_t i=0; i<buffers.size(); ++i)
+	{
+		if(buffers[i].get_num_dropped() > 0)
+			return false;
+		for(const auto& event: buffers[i].get_events())
+		{
+			begin = std::min(begin, event.start);
+			if(name == nullptr || (i == 0 && std::string(event.name) == name))
+				end = std::max(end, event.start + event.duration);
+		}
+	}
+	if(end < begin)
+		return false;
+	seconds = 1E-9*(end - begin);
+	return true;
+}
+
+template<class ModelType>
+Result run(const std::string& workload, const std::string& parameters,
+			const ModelType& prototype, unsigned int num_threads,
+			unsigned int saves_per_thread)
+{
+	const unsigned int max_num_levels = 20;
+	Options options(5, 1000, 1000, 100, max_num_levels, 10., 100.,
+					saves_per_thread*num_threads, false);
+	options.prefix_filenames("bench_");
+
+	// Keep the sampler's messages out of the results
+	Sampler<ModelType> sampler(num_threads, exp(1.), options, false, false,
+								prototype);
+	sampler.get_logger().set_level(LogLevel::off);
+	sampler.set_profiling(true);
+	sampler.set_tracing(true);
+	sampler.initialise(0);
+	auto start = std::chrono::steady_clock::now();
+	sampler.run();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	for(const std::string& filename: {options.sample_file,
+					options.sample_info_file, options.levels_file,
+					options.checkpoint_file, options.best_particle_file,
+					options.best_likelihood_file})
+		std::remove(filename.c_str());
+
+	Result result;
+	result.workload = workload;
+	result.parameters = parameters;
+	result.num_threads = num_threads;
+	result.steps = sampler.get_count_mcmc_steps();
+	result.likelihood_evaluations = sampler.get_count_likelihood_evaluations();
+	result.num_levels = sampler.get_levels().size();
+
+	// run() only looks for the end of the run once a second, so take the
+	// times from the timeline where it is complete
+	const auto& buffers = sampler.get_trace_buffers();
+	if(!trace_span(buffers, nullptr, result.seconds))
+		result.seconds = elapsed.count();
+	if(result.num_levels < max_num_levels ||
+		!trace_span(buffers, "level_creation", result.level_creation_seconds))
+		result.level_creation_seconds = std::nan("");
+
+	const PhaseCounters& counters = sampler.get_phase_counters()[0];
+	result.bookkeeping_seconds = counters.get_seconds(Phase::bookkeeping);
+	result.bookkeeping_calls = counters.get_calls(Phase::bookkeeping);
+	result.checkpoint_seconds = counters.get_seconds(Phase::save_checkpoint);
+	result.checkpoint_calls = counters.get_calls(Phase::save_checkpoint);
+
+	std::cerr << "# " << workload << ' ' << parameters << " on ";
+	std::cerr << num_threads << " thread(s): " << std::fixed;
+	std::cerr << std::setprecision(0) << result.steps/result.seconds;
+	std::cerr << " steps/s." << std::endl;
+	return result;
+}
+
+void print_json(std::ostream& out, const std::vector<Result>& results,
+				unsigned int max_num_threads)
+{
+	auto number = [](double x) -> std::string
+	{
+		if(std::isnan(x))
+			return "null";
+		std::stringstream s;
+		s << std::setprecision(6) << x;
+		return s.str();
+	};
+
+	out << "{" << std::endl;
+	out << "  \"version\": \"" << DNEST4_MAJOR_VERSION << '.';
+	out << DNEST4_MINOR_VERSION << '.' << DNEST4_PATCH_VERSION << "\"," << std::endl;
+	out << "  \"max_num_threads\": " << max_num_threads << ',' << std::endl;
+	out << "  \"results\": [" << std::endl;
+	for(size_t i=0; i<results.size(); ++i)
+	{
+		const Result& r = results[i];
+		double mean_bookkeeping = r.bookkeeping_seconds/std::max(r.bookkeeping_calls, 1ULL);
+		double mean_checkpoint = r.checkpoint_seconds/std::max(r.checkpoint_calls, 1ULL);
+
+		out << "    {\"workload\": \"" << r.workload << "\", ";
+		out << "\"parameters\": {" << r.parameters << "}, ";
+		out << "\"threads\": " << r.num_threads << ", ";
+		out << "\"steps\": " << r.steps << ", ";
+		out << "\"seconds\": " << number(r.seconds) << ", ";
+		out << "\"steps_per_second\": " << number(r.steps/r.seconds) << ", ";
+		out << "\"likelihood_evaluations_per_second\": ";
+		out << number(r.likelihood_evaluations/r.seconds) << ", ";
+		out << "\"levels\": " << r.num_levels << ", ";
+		out << "\"level_creation_seconds\": " << number(r.level_creation_seconds) << ", ";
+		out << "\"bookkeeping_seconds\": " << number(r.bookkeeping_seconds) << ", ";
+		out << "\"mean_bookkeeping_seconds\": " << number(mean_bookkeeping) << ", ";
+		out << "\"checkpoint_seconds\": " << number(r.checkpoint_seconds) << ", ";
+		out << "\"mean_checkpoint_seconds\": " << number(mean_checkpoint) << "}";
+		out << ((i + 1 < results.size())?(","):("")) << std::endl;
+	}
+	out << "  ]" << std::endl;
+	out << "}" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int max_num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+	if(argc > 1)
+		std::stringstream(argv[1]) >> max_num_threads;
+
+	// 1, 2, 4, ... and max_num_threads
+	std::vector<unsigned int> thread_counts;
+	for(unsigned int n=1; n<max_num_threads; n*=2)
+		thread_counts.push_back(n);
+	thread_counts.push_back(max_num_threads);
+
+	std::vector<Result> results;
+
+	for(size_t dimensions: {2, 10, 100, 1000})
+		results.push_back(run("gaussian",
+						"\"dimensions\": " + std::to_string(dimensions),
+						StandardNormal(dimensions), 1, 200));
+
+	// A straight line through 10000 points
+	std::vector<double> x(10000), y(10000);
+	RNG rng(0);
+	for(size_t i=0; i<x.size(); ++i)
+	{
+		x[i] = 10.*i/x.size();
+		y[i] = 3.*x[i] + 1. + rng.randn();
+	}
+	StraightLine line(std::make_shared<const Data>(x, y));
+	for(unsigned int num_threads: thread_counts)
+		results.push_back(run("straight_line", "\"points\": 10000", line,
+						num_threads, 100));
+
+	SineWaves sine_waves(SineWaves::make_data(1000));
+	for(unsigned int num_threads: thread_counts)
+		results.push_back(run("sine_waves", "\"points\": 1000", sine_waves,
+						num_threads, 100));
+
+	print_json(std::cout, results, max_num_threads);
+
+	return 0;
+}
+
@@ -16,6 +16,22 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 ,compression("2.7182818284590451")
 ,num_threads(1)
 ,config_file("")
+,warm_start_file("")
+,warm_start_thin(1)
+,warm_start_respace(false)
+,coordinator_address("")
+,control_file("")
+,stopping_rules()
+,optimiser_top_k(0)
+,thread_steps_overhead(0.)
+,drain_deadline(25)
+,galilean_probability(0.)
+,slice_probability(0.)
+,ensemble_probability(0.)
+,proposal_target(0.)
+,delayed_acceptance(false)
+,num_tries(1)
+,num_pool_workers(-1)
 ,adaptive(false)
 {
 	// The following code is based on the example given at
@@ -23,9 +39,10 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 
 	int c;
 	std::stringstream s;
+	bool compression_given = false;
 
 	opterr = 0;
-	while((c = getopt(argc, argv, "hao:s:d:c:t:f:")) != -1)
+	while((c = getopt(argc, argv, "hao:s:d:c:t:f:w:r:T:e:z:k:E:O:u:C:D:G:S:M:A:ym:P:I:x:R:L:l:W:F")) != -1)
 	switch(c)
 	{
 		case 'h':
@@ -45,6 +62,7 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 			break;
 		case 'c':
 			compression = std::string(optarg);
+			compression_given = true;
 			break;
 		case 't':
 			s<<optarg;
@@ -53,6 +71,83 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 		case 'f':
 			config_file = std::string(optarg);
 			break;
+		case 'w':
+			warm_start_file = std::string(optarg);
+			break;
+		case 'W':
+			std::stringstream(optarg)>>warm_start_thin;
+			if(warm_start_thin == 0)
+				warm_start_thin = 1;
+			break;
+		case 'F':
+			warm_start_respace = true;
+			break;
+		case 'r':
+			coordinator_address = std::string(optarg);
+			break;
+		case 'T':
+			std::stringstream(optarg)>>stopping_rules.max_run_time;
+			break;
+		case 'e':
+			std::stringstream(optarg)>>stopping_rules.max_num_likelihood_evaluations;
+			break;
+		case 'z':
+			std::stringstream(optarg)>>stopping_rules.log_Z_tolerance;
+			break;
+		case 'k':
+			std::stringstream(optarg)>>stopping_rules.log_Z_window;
+			break;
+		case 'E':
+			std::stringstream(optarg)>>stopping_rules.target_ess;
+			break;
+		case 'O':
+			std::stringstream(optarg)>>optimiser_top_k;
+			break;
+		case 'C':
+			control_file = std::string(optarg);
+			break;
+		case 'D':
+			std::stringstream(optarg)>>drain_deadline;
+			break;
+		case 'G':
+			std::stringstream(optarg)>>galilean_probability;
+			break;
+		case 'S':
+			std::stringstream(optarg)>>slice_probability;
+			break;
+		case 'M':
+			std::stringstream(optarg)>>ensemble_probability;
+			break;
+		case 'A':
+			std::stringstream(optarg)>>proposal_target;
+			break;
+		case 'y':
+			delayed_acceptance = true;
+			break;
+		case 'm':
+			std::stringstream(optarg)>>num_tries;
+			break;
+		case 'P':
+			std::stringstream(optarg)>>num_pool_workers;
+			break;
+		case 'I':
+			profile_file = std::string(optarg);
+			break;
+		case 'x':
+			trace_file = std::string(optarg);
+			break;
+		case 'R':
+			metrics_file = std::string(optarg);
+			break;
+		case 'L':
+			metrics_address = std::string(optarg);
+			break;
+		case 'l':
+			log_file = std::string(optarg);
+			break;
+		case 'u':
+			std::stringstream(optarg)>>thread_steps_overhead;
+			break;
 		case '?':
 			std::cerr<<"# Option "<<optopt<<" requires an argument."<<std::endl;
 			if(isprint(optopt))
@@ -67,6 +162,10 @@ CommandLineOptions::CommandLineOptions(int argc, char** argv)
 	for(int index = optind; index < argc; index++)
 		std::cout<<"# Non-option argument "<<argv[index]<<std::endl;
 
+	// The optimiser climbs faster with more compression between levels
+	if(optimiser_top_k > 0 && !compression_given)
+		compression = "10";
+
 	if(num_threads <= 0)
 	{
 		std::cerr<<"# Invalid number of threads: "<<num_threads<<"."<<std::endl;
@@ -104,6 +203,31 @@ void CommandLineOptions::print_help() const
 	std::cout<<"-c <value>: Specify a compression value (between levels) other than e."<<std::endl;
 	std::cout<<"-t <num_threads>: run on the specified number of threads. Default=1."<<std::endl;
 	std::cout<<"-f <filename>: a custom configuration file for adding problem specific options if required."<<std::endl;
+	std::cout<<"-w <filename>: warm start from the levels of a previous run (a levels file or checkpoint)."<<std::endl;
+	std::cout<<"-W <n>: with -w, keep only every nth level."<<std::endl;
+	std::cout<<"-F: with -w, re-space the levels to this run's compression factor."<<std::endl;
+	std::cout<<"-r <host:port>: share levels through a coordinator at this address. The coordinator itself listens at [host:]port, on this machine only unless a host is given (e.g. 0.0.0.0:port for all interfaces, which lets anyone who can reach the port send levels to the workers)."<<std::endl;
+	std::cout<<"-C <filename>: take commands (e.g. \"save_interval 100\", \"checkpoint\", \"trace\", \"stop\") from this file while running."<<std::endl;
+	std::cout<<"-D <seconds>: on SIGTERM, save a checkpoint and exit within this many seconds. Default=25."<<std::endl;
+	std::cout<<"-G <probability>: replace this fraction of moves with Galilean trajectories (the model needs coordinates and a gradient)."<<std::endl;
+	std::cout<<"-S <probability>: replace this fraction of moves with slice sampling (the model needs coordinates)."<<std::endl;
+	std::cout<<"-M <probability>: replace this fraction of moves with ensemble (differential evolution and stretch) moves (the model needs coordinates)."<<std::endl;
+	std::cout<<"-A <rate>: scale the proposals of each level towards this acceptance rate while creating levels."<<std::endl;
+	std::cout<<"-y: screen proposals with the model's surrogate likelihood (approx_log_likelihood()) before computing the exact one."<<std::endl;
+	std::cout<<"-m <num_tries>: make this many proposals at once and evaluate them in parallel on the spare cores (multiple-try Metropolis)."<<std::endl;
+	std::cout<<"-P <num_workers>: give the model's parallel_for() and parallel_reduce() a pool of this many threads (0 for one per spare core)."<<std::endl;
+	std::cout<<"-I <filename>: time each phase of the sampler and write a summary to this file every ten seconds."<<std::endl;
+	std::cout<<"-x <filename>: record what each thread does and write it to this file (Chrome trace format) at the end."<<std::endl;
+	std::cout<<"-R <filename>: keep metrics for monitoring (Prometheus text format) in this file."<<std::endl;
+	std::cout<<"-L <port or path>: serve the metrics over HTTP on this local port or Unix socket."<<std::endl;
+	std::cout<<"-l <filename>: also append the sampler's messages to this file."<<std::endl;
+	std::cout<<"-T <seconds>: stop after this much wall-clock time."<<std::endl;
+	std::cout<<"-e <number>: stop after this many likelihood evaluations."<<std::endl;
+	std::cout<<"-z <tolerance>: once all levels exist, stop when log(Z) is stable to within this tolerance over the last K estimates (made every 1% of the saves)."<<std::endl;
+	std::cout<<"-k <K>: number of estimates for -z. Default=10."<<std::endl;
+	std::cout<<"-E <ess>: once all levels exist, stop when the effective sample size reaches this value."<<std::endl;
+	std::cout<<"-O <k>: run as an optimiser, keeping the best k particles of each thread. Compression defaults to 10."<<std::endl;
+	std::cout<<"-u <percent>: choose threadSteps automatically, keeping the time spent outside MCMC near this percentage."<<std::endl;
 	exit(0);
 }
 
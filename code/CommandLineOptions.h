@@ -2,6 +2,7 @@
 #define DNest4_CommandLineOptions
 
 #include <string>
+#include "StoppingRules.h"
 
 namespace DNest4
 {
@@ -20,6 +21,27 @@ class CommandLineOptions
 		std::string compression;
 		int num_threads;
         std::string config_file;
+        std::string warm_start_file;
+        unsigned int warm_start_thin;
+        bool warm_start_respace;
+        std::string coordinator_address;
+        std::string control_file;
+        StoppingRules stopping_rules;
+        unsigned int optimiser_top_k;
+        double thread_steps_overhead;
+        unsigned int drain_deadline;
+        double galilean_probability;
+        double slice_probability;
+        double ensemble_probability;
+        double proposal_target;
+        bool delayed_acceptance;
+        unsigned int num_tries;
+        int num_pool_workers;
+        std::string profile_file;
+        std::string trace_file;
+        std::string metrics_file;
+        std::string metrics_address;
+        std::string log_file;
         bool adaptive;        
 
 	public:
@@ -43,6 +65,85 @@ class CommandLineOptions
                 const std::string& get_config_file() const
                 { return config_file; }
 
+        const std::string& get_warm_start_file() const
+        { return warm_start_file; }
+
+        // Keep every nth warm-start level, and/or re-space them
+        unsigned int get_warm_start_thin() const
+        { return warm_start_thin; }
+        bool get_warm_start_respace() const
+        { return warm_start_respace; }
+
+        const std::string& get_coordinator_address() const
+        { return coordinator_address; }
+
+        const std::string& get_control_file() const
+        { return control_file; }
+
+        const StoppingRules& get_stopping_rules() const
+        { return stopping_rules; }
+
+        // Zero unless the sampler should run as an optimiser
+        unsigned int get_optimiser_top_k() const
+        { return optimiser_top_k; }
+
+        // Target overhead (in percent) for choosing thread_steps
+        // automatically, or zero to use the OPTIONS file value
+        double get_thread_steps_overhead() const
+        { return thread_steps_overhead; }
+
+        // Seconds allowed for checkpointing after SIGTERM
+        unsigned int get_drain_deadline() const
+        { return drain_deadline; }
+
+        // Fraction of moves done by Galilean trajectories
+        double get_galilean_probability() const
+        { return galilean_probability; }
+
+        // Fraction of moves done by slice sampling
+        double get_slice_probability() const
+        { return slice_probability; }
+
+        // Fraction of moves done by ensemble moves
+        double get_ensemble_probability() const
+        { return ensemble_probability; }
+
+        // Target acceptance rate for scaling perturb() per level
+        double get_proposal_target() const
+        { return proposal_target; }
+
+        // Whether to screen proposals with the model's surrogate likelihood
+        bool get_delayed_acceptance() const
+        { return delayed_acceptance; }
+
+        // Proposals made at once by multiple-try moves
+        unsigned int get_num_tries() const
+        { return num_tries; }
+
+        // Workers in the pool for the model's parallel work (0 for one
+        // per spare core, negative for no pool)
+        int get_num_pool_workers() const
+        { return num_pool_workers; }
+
+        // Where to write per-phase timings (empty for no profiling)
+        const std::string& get_profile_file() const
+        { return profile_file; }
+
+        // Where to write the timeline of each thread (empty for none)
+        const std::string& get_trace_file() const
+        { return trace_file; }
+
+        // Where to publish metrics: a file, and a loopback port or Unix
+        // socket path to serve them on (empty for neither)
+        const std::string& get_metrics_file() const
+        { return metrics_file; }
+        const std::string& get_metrics_address() const
+        { return metrics_address; }
+
+        // Where else to write the sampler's messages (empty for nowhere)
+        const std::string& get_log_file() const
+        { return log_file; }
+
         bool get_adaptive() const
         { return adaptive; }
 
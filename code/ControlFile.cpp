@@ -0,0 +1,50 @@
+#include "ControlFile.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace DNest4
+{
+
+ControlFile::ControlFile(const std::string& filename, double interval)
+:filename(filename)
+,interval(interval)
+,last_check(std::chrono::steady_clock::now())
+{
+
+}
+
+bool ControlFile::poll(std::vector< std::pair<std::string, std::string> >& commands)
+{
+	auto now = std::chrono::steady_clock::now();
+	if(std::chrono::duration<double>(now - last_check).count() < interval)
+		return false;
+	last_check = now;
+
+	// Take the file out of the way first, so nothing written
+	// after this point is lost
+	std::string taken = filename + ".reading";
+	if(std::rename(filename.c_str(), taken.c_str()) != 0)
+		return false;
+
+	commands.clear();
+	std::fstream fin(taken, std::ios::in);
+	std::string line;
+	while(std::getline(fin, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::stringstream s(line);
+		std::string name, value;
+		if(!(s>>name))
+			continue;
+		s>>value;
+		commands.push_back(std::make_pair(name, value));
+	}
+	fin.close();
+	std::remove(taken.c_str());
+
+	return commands.size() > 0;
+}
+
+} // namespace DNest4
+
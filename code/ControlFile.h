@@ -0,0 +1,41 @@
+#ifndef DNest4_ControlFile
+#define DNest4_ControlFile
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace DNest4
+{
+
+/*
+* A file through which a running sampler can be given commands, one per
+* line as "name [value]", with comments starting with '#'. The file is
+* consumed when read, so each command is applied once. Write it to a
+* temporary name and rename it into place so it is never read half done.
+*/
+class ControlFile
+{
+	private:
+		std::string filename;
+
+		// Don't look at the file more often than this (in seconds)
+		double interval;
+		std::chrono::steady_clock::time_point last_check;
+
+	public:
+		explicit ControlFile(const std::string& filename, double interval=1.);
+
+		// Read any new commands into 'commands'. Returns false if there
+		// were none (or it is too soon to look again).
+		bool poll(std::vector< std::pair<std::string, std::string> >& commands);
+
+		const std::string& get_filename() const
+		{ return filename; }
+};
+
+} // namespace DNest4
+
+#endif
+
@@ -0,0 +1,320 @@
+#include "Coordinator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+using namespace std;
+
+namespace DNest4
+{
+
+Coordinator::Coordinator(const string& host, unsigned short port,
+							double compression, const Options& options,
+							unsigned int round_time)
+:listener(Socket::listen(host, port))
+,compression(compression)
+,options(options)
+,levels(1, Level(LikelihoodType()))
+,round_time(round_time)
+,count_rounds(0)
+,count_messages(0)
+{
+	logger.info()<<"# Coordinator listening on "<<host<<':'<<port<<".";
+	if(host != "localhost" && host.compare(0, 4, "127.") != 0 && host != "::1")
+		logger.warning()<<"# Anyone who can reach "<<host<<':'<<port
+			<<" can send levels to every worker. Only listen beyond "
+			<<"this machine on a trusted network.";
+	save_levels();
+}
+
+void Coordinator::merge(const string& message, size_t worker)
+{
+	stringstream s(message);
+
+	// Counter increments, one per level the worker knows about
+	size_t num_levels;
+	s>>num_levels;
+	vector<Level> deltas(num_levels);
+	for(Level& delta: deltas)
+		delta.read(s);
+
+	size_t num_above;
+	s>>num_above;
+	vector<LikelihoodType> above(num_above);
+	for(LikelihoodType& l: above)
+		l.read(s);
+	sort(above.begin(), above.end());
+
+	// Tiebreakers make it all but impossible for independent workers to
+	// send the same likelihood, so a repeat means a duplicate chain
+	for(size_t j=0; j<workers.size(); ++j)
+	{
+		if(j == worker)
+			continue;
+		vector<LikelihoodType> common;
+		set_intersection(above.begin(), above.end(),
+						recent_above[j].begin(), recent_above[j].end(),
+						back_inserter(common));
+		if(common.size() > 0)
+		{
+			if(!warned[worker])
+				logger.warning()<<"# A worker is sending the same likelihoods "
+					<<"as another one, so its messages will be ignored. "
+					<<"Give each worker its own seed (-s).";
+			warned[worker] = true;
+			return;
+		}
+	}
+	recent_above[worker] = above;
+
+	for(size_t i=0; i<deltas.size() && i<levels.size(); ++i)
+	{
+		levels[i].increment_accepts(deltas[i].get_accepts());
+		levels[i].increment_tries(deltas[i].get_tries());
+		levels[i].increment_visits(deltas[i].get_visits());
+		levels[i].increment_exceeds(deltas[i].get_exceeds());
+	}
+
+	// A slow worker may send likelihoods that are no longer above the top
+	for(const LikelihoodType& l: above)
+	{
+		if(!Level::enough_levels(levels, options.max_num_levels) &&
+			levels.back().get_log_likelihood() < l)
+			all_above.push_back(l);
+	}
+	++count_messages;
+}
+
+void Coordinator::do_bookkeeping()
+{
+	bool created = false;
+	while(!Level::enough_levels(levels, options.max_num_levels) &&
+			(all_above.size() >= options.new_level_interval))
+	{
+		// Create the level
+		sort(all_above.begin(), all_above.end());
+		int index = static_cast<int>((1. - 1./compression)*all_above.size());
+		logger.info()<<"# Creating level "<<levels.size()<<" with log likelihood = "
+			<<all_above[index].get_value()<<".";
+
+		levels.push_back(Level(all_above[index]));
+		all_above.erase(all_above.begin(), all_above.begin() + index + 1);
+		created = true;
+
+		// If last level
+		if(Level::enough_levels(levels, options.max_num_levels))
+		{
+			// Regularisation
+			double reg = options.new_level_interval*sqrt(options.lambda);
+			Level::renormalise_visits(levels, static_cast<int>(reg));
+			all_above.clear();
+			logger.info()<<"# Done creating levels.";
+		}
+	}
+
+	// Recalculate log_X values of levels
+	Level::recalculate_log_X(levels, compression,
+						options.new_level_interval*sqrt(options.lambda));
+
+	if(created)
+		save_levels();
+}
+
+void Coordinator::run()
+{
+#ifndef _WIN32
+	bool had_workers = false;
+	while(!had_workers || workers.size() > 0)
+	{
+		vector<bool> sent(workers.size(), false);
+		vector<bool> lost(workers.size(), false);
+		size_t num_sent = 0;
+		bool round_started = false;
+		auto deadline = chrono::steady_clock::now();
+
+		// Wait for the first message of the round, then give the other
+		// workers until the deadline to catch up
+		while(true)
+		{
+			int timeout = 1000;
+			if(round_started)
+			{
+				auto left = chrono::duration_cast<chrono::milliseconds>
+								(deadline - chrono::steady_clock::now());
+				timeout = max(0, static_cast<int>(left.count()));
+			}
+
+			vector<pollfd> fds(1 + workers.size());
+			fds[0].fd = listener.get_fd();
+			fds[0].events = POLLIN;
+			for(size_t i=0; i<workers.size(); ++i)
+			{
+				fds[i+1].fd = (sent[i] || lost[i])?(-1):(workers[i].get_fd());
+				fds[i+1].events = POLLIN;
+			}
+			int ready = poll(&fds[0], fds.size(), timeout);
+
+			if(ready > 0)
+			{
+				for(size_t i=0; i<workers.size(); ++i)
+				{
+					if(fds[i+1].fd < 0 || !(fds[i+1].revents & (POLLIN | POLLHUP | POLLERR)))
+						continue;
+					// Take what has arrived, so a worker that has only
+					// sent part of its message doesn't hold up the round
+					string message;
+					bool complete = false;
+					if(!workers[i].receive_available(message, complete))
+						lost[i] = true;
+					else if(complete)
+					{
+						merge(message, i);
+						sent[i] = true;
+						++num_sent;
+						if(!round_started)
+						{
+							round_started = true;
+							deadline = chrono::steady_clock::now()
+										+ chrono::milliseconds(round_time);
+						}
+					}
+				}
+
+				// New workers join the current round
+				if(fds[0].revents & POLLIN)
+				{
+					Socket s = listener.accept();
+					if(s.is_open())
+					{
+						logger.info()<<"# Worker connected.";
+						workers.push_back(std::move(s));
+						recent_above.push_back(vector<LikelihoodType>());
+						warned.push_back(false);
+						sent.push_back(false);
+						lost.push_back(false);
+						had_workers = true;
+					}
+				}
+			}
+
+			size_t num_live = 0;
+			for(size_t i=0; i<sent.size(); ++i)
+				if(!lost[i])
+					++num_live;
+			if(round_started && (num_sent == num_live ||
+								chrono::steady_clock::now() >= deadline))
+				break;
+			if(!round_started && had_workers && num_live == 0)
+				break;
+		}
+
+		if(round_started)
+		{
+			do_bookkeeping();
+			++count_rounds;
+
+			// Reply to the workers heard from this round
+			stringstream s;
+			s<<hexfloat;
+			s<<levels.size()<<' ';
+			for(const Level& level: levels)
+				level.print(s);
+			for(size_t i=0; i<sent.size(); ++i)
+				if(sent[i] && !workers[i].send_message(s.str()))
+					lost[i] = true;
+		}
+
+		// Drop workers that have gone away
+		for(int i=static_cast<int>(lost.size())-1; i>=0; --i)
+		{
+			if(lost[i])
+			{
+				logger.info()<<"# Worker disconnected.";
+				workers.erase(workers.begin() + i);
+				recent_above.erase(recent_above.begin() + i);
+				warned.erase(warned.begin() + i);
+			}
+		}
+	}
+
+	logger.info()<<"# All workers finished after "<<count_rounds<<" rounds ("
+		<<count_messages<<" messages).";
+	logger.flush();
+	save_levels();
+#endif
+}
+
+void Coordinator::save_levels() const
+{
+	fstream fout(options.levels_file, ios::out);
+	fout<<"# log_X, log_likelihood, tiebreaker, accepts, tries, exceeds, visits";
+	fout<<endl;
+	if(options.write_exact_representation)
+		fout<<hexfloat;
+	else
+		fout<<scientific<<setprecision(16);
+
+	for(const Level& level: levels)
+	{
+		fout<<level.get_log_X()<<' ';
+		fout<<level.get_log_likelihood().get_value()<<' ';
+		fout<<level.get_log_likelihood().get_tiebreaker()<<' ';
+		fout<<level.get_accepts()<<' ';
+		fout<<level.get_tries()<<' ';
+		fout<<level.get_exceeds()<<' ';
+		fout<<level.get_visits()<<endl;
+	}
+	fout.close();
+}
+
+CoordinatorClient::CoordinatorClient(const string& address)
+{
+	string host;
+	unsigned short port;
+	if(parse_address(address, host, port))
+		socket = Socket::connect(host, port);
+}
+
+bool CoordinatorClient::exchange(const vector<Level>& deltas,
+									const vector<LikelihoodType>& above,
+									vector<Level>& levels)
+{
+	stringstream s;
+	s<<hexfloat;
+	s<<deltas.size()<<' ';
+	for(const Level& delta: deltas)
+		delta.print(s);
+	s<<above.size()<<' ';
+	for(const LikelihoodType& l: above)
+		l.print(s);
+
+	string reply;
+	if(!socket.send_message(s.str()) || !socket.receive_message(reply))
+	{
+		socket.close();
+		return false;
+	}
+
+	stringstream r(reply);
+	size_t num_levels;
+	r>>num_levels;
+	levels.clear();
+	for(size_t i=0; i<num_levels; ++i)
+	{
+		Level level;
+		level.read(r);
+		levels.push_back(level);
+	}
+	return true;
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,107 @@
+#ifndef DNest4_Coordinator
+#define DNest4_Coordinator
+
+#include <string>
+#include <vector>
+#include "Level.h"
+#include "LikelihoodType.h"
+#include "Logger.h"
+#include "Options.h"
+#include "Socket.h"
+
+namespace DNest4
+{
+
+/*
+* Shares one set of levels between sampler processes, possibly on
+* different hosts. At the end of each round every worker sends the
+* increments to its level counters and the likelihoods it saw above the
+* top level. The coordinator merges whatever arrived during the round,
+* creates new levels as a single sampler would, and sends the levels back.
+*/
+class Coordinator
+{
+	private:
+		// Listening socket and one connection per worker
+		Socket listener;
+		std::vector<Socket> workers;
+
+		// The likelihoods each worker last had merged, sorted, and
+		// whether it has been warned about sending another's
+		std::vector< std::vector<LikelihoodType> > recent_above;
+		std::vector<bool> warned;
+
+		// Compression and options, as for a Sampler
+		double compression;
+		Options options;
+
+		// The shared levels and storage for creating new ones
+		std::vector<Level> levels;
+		std::vector<LikelihoodType> all_above;
+
+		// How long (in milliseconds) a round waits for slow workers
+		unsigned int round_time;
+
+		// Where progress messages go
+		Logger logger;
+
+		// Number of rounds and of worker messages merged so far
+		unsigned long long int count_rounds;
+		unsigned long long int count_messages;
+
+		// Apply the message of worker 'worker' to the levels, unless it
+		// repeats likelihoods another worker sent (as identically seeded
+		// workers do)
+		void merge(const std::string& message, size_t worker);
+
+		// Create levels and recalculate log_X
+		void do_bookkeeping();
+
+		void save_levels() const;
+
+	public:
+		// Constructor: listen on 'port' of the interface 'host' resolves
+		// to. Workers aren't authenticated, so any host other than a
+		// loopback one lets whoever can reach the port inject levels.
+		Coordinator(const std::string& host, unsigned short port,
+					double compression, const Options& options,
+					unsigned int round_time=100);
+
+		// Serve workers until they have all disconnected
+		void run();
+
+		const std::vector<Level>& get_levels() const
+		{ return levels; }
+
+		// The coordinator's messages (see Logger.h)
+		Logger& get_logger()
+		{ return logger; }
+};
+
+/*
+* The worker's side of the connection to a Coordinator
+*/
+class CoordinatorClient
+{
+	private:
+		Socket socket;
+
+	public:
+		// Connect to a coordinator at "host:port"
+		explicit CoordinatorClient(const std::string& address);
+
+		bool is_connected() const
+		{ return socket.is_open(); }
+
+		// Send increments of the level counters (one Level per level) and
+		// the likelihoods above the top level, and receive the shared levels.
+		// Returns false if the coordinator has gone away.
+		bool exchange(const std::vector<Level>& deltas,
+						const std::vector<LikelihoodType>& above,
+						std::vector<Level>& levels);
+};
+
+} // namespace DNest4
+
+#endif
+
@@ -7,13 +7,32 @@
 
 #include "Version.h"
 #include "Barrier.h"
+#include "Batch.h"
 #include "CommandLineOptions.h"
+#include "ControlFile.h"
+#include "Coordinator.h"
+#include "DelayedAcceptance.h"
+#include "EnsembleMove.h"
+#include "GalileanMove.h"
 #include "Level.h"
 #include "LikelihoodType.h"
+#include "Logger.h"
+#include "MetricsServer.h"
+#include "ModelBenchmark.h"
+#include "ModelTraits.h"
 #include "Options.h"
+#include "Parallel.h"
+#include "Profiler.h"
 #include "RNG.h"
+#include "RunMerger.h"
 #include "Sampler.h"
+#include "SignalHandling.h"
+#include "SliceMove.h"
+#include "Socket.h"
 #include "Start.h"
+#include "StoppingRules.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include "Utils.h"
 #include "RJObject/RJObject.h"
 #include "RJObject/Normals.h"
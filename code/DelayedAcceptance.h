@@ -0,0 +1,51 @@
+#ifndef DNest4_DelayedAcceptance
+#define DNest4_DelayedAcceptance
+
+#include <algorithm>
+#include "ModelTraits.h"
+
+namespace DNest4
+{
+
+/*
+* The first stage of a delayed acceptance move (Christen & Fox, 2005).
+* A proposal is first accepted or rejected for the surrogate target
+* prior(x)*w(x), where w(x) = min(1, exp(approx_log_likelihood - threshold)),
+* and only the survivors are checked against the level with the exact
+* likelihood, then kept with probability min(1, w(x)/w(x')). Softening
+* the surrogate constraint below the threshold keeps w(x) positive,
+* so a particle the surrogate disagrees about can still move, and the
+* two stages together leave the target unchanged.
+*/
+template<class ModelType, bool = has_approx_log_likelihood<ModelType>::value>
+class DelayedAcceptance
+{
+	public:
+		static bool available()
+		{ return false; }
+
+		static double log_weight_ratio(const ModelType&, double)
+		{ return 0.; }
+};
+
+template<class ModelType>
+class DelayedAcceptance<ModelType, true>
+{
+	public:
+		static bool available()
+		{ return true; }
+
+		// log(w(x')/w(x)) for the proposal x' held by 'particle'
+		static double log_weight_ratio(const ModelType& particle,
+										double threshold)
+		{
+			return std::min(particle.proposal_approx_log_likelihood()
+								- threshold, 0.)
+					- std::min(particle.approx_log_likelihood() - threshold, 0.);
+		}
+};
+
+} // namespace DNest4
+
+#endif
+
@@ -0,0 +1,104 @@
+#ifndef DNest4_EnsembleMove
+#define DNest4_EnsembleMove
+
+#include <cmath>
+#include <vector>
+#include "LikelihoodType.h"
+#include "ModelTraits.h"
+#include "RNG.h"
+
+namespace DNest4
+{
+
+/*
+* Moves which use the positions of other particles to propose a new one,
+* so that proposals follow the shape of the region above the level
+* threshold. Half are differential evolution moves (ter Braak, 2006)
+* along the difference of two other particles, which are symmetric.
+* The rest are stretch moves (Goodman & Weare, 2010) along the line
+* through another particle, with Hastings factor z^(n-1). Both are valid
+* because the other particles are held fixed during the move. Needs the
+* coordinate interface described in ModelTraits.h.
+*/
+template<class ModelType, bool = has_coordinates<ModelType>::value>
+class EnsembleMove
+{
+	public:
+		static bool available()
+		{ return false; }
+
+		static bool move(ModelType&, LikelihoodType&, const LikelihoodType&,
+						const ModelType&, const ModelType&, RNG&,
+						unsigned long long int&)
+		{ return false; }
+};
+
+template<class ModelType>
+class EnsembleMove<ModelType, true>
+{
+	public:
+		static bool available()
+		{ return true; }
+
+		// Move 'particle' using two others, 'a' and 'b', keeping it above
+		// 'threshold'. Returns whether the proposal was accepted.
+		static bool move(ModelType& particle, LikelihoodType& logl,
+						const LikelihoodType& threshold,
+						const ModelType& a, const ModelType& b, RNG& rng,
+						unsigned long long int& count_evaluations)
+		{
+			std::vector<double> u, ua, ub;
+			particle.get_coordinates(u);
+			a.get_coordinates(ua);
+			b.get_coordinates(ub);
+			const size_t n = u.size();
+
+			std::vector<double> u_new(n);
+			double log_H = 0.;
+			if(rng.rand() <= 0.5)
+			{
+				// Differential evolution, with occasional full jumps
+				// between modes and a little noise
+				double gamma = (rng.rand() <= 0.1)?(1.):(2.38/std::sqrt(2.*n));
+				for(size_t i=0; i<n; ++i)
+					u_new[i] = u[i] + gamma*(ua[i] - ub[i]) + 1E-6*rng.randn();
+			}
+			else
+			{
+				// Stretch move with scale 2: z has density
+				// proportional to 1/sqrt(z) on [1/2, 2]
+				double z = pow(1. + rng.rand(), 2)/2.;
+				for(size_t i=0; i<n; ++i)
+					u_new[i] = ua[i] + z*(u[i] - ua[i]);
+				log_H = (n - 1.)*log(z);
+			}
+
+			// The prior is zero outside the hypercube
+			for(double ui: u_new)
+				if(ui < 0. || ui > 1.)
+					return false;
+
+			if(log_H < 0. && rng.rand() >= exp(log_H))
+				return false;
+
+			// Evaluated on a copy, as for multiple-try proposals, so that
+			// a rejection leaves the particle as it was
+			ModelType proposal(particle);
+			proposal.set_coordinates(u_new);
+			++count_evaluations;
+			LikelihoodType logl_proposal(proposal.log_likelihood(),
+											logl.get_tiebreaker());
+			logl_proposal.perturb(rng);
+
+			if(!(threshold < logl_proposal))
+				return false;
+			particle = proposal;
+			logl = logl_proposal;
+			return true;
+		}
+};
+
+} // namespace DNest4
+
+#endif
+
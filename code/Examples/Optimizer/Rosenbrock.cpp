@@ -0,0 +1,159 @@
+#include "Rosenbrock.h"
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+using namespace DNest4;
+
+Rosenbrock::Rosenbrock()
+:x(num_params)
+,x_proposed(num_params)
+{
+
+}
+
+double Rosenbrock::f(const vector<double>& x)
+{
+	double result = 0.;
+	for(size_t i=0; i+1<x.size(); ++i)
+		result += 100.*pow(x[i+1] - x[i]*x[i], 2) + pow(1. - x[i], 2);
+	return result;
+}
+
+void Rosenbrock::from_prior(size_t i)
+{
+	RNG rng(i);
+	for(double& xi: x)
+		xi = -10. + 20.*rng.rand();
+	x_proposed = x;
+}
+
+double Rosenbrock::perturb(RNG& rng)
+{
+	x_proposed = x;
+
+	// Move one or a few coordinates
+	int reps = 1;
+	if(rng.rand() <= 0.5)
+		reps = static_cast<int>(pow(num_params, rng.rand()));
+	for(int i=0; i<reps; ++i)
+	{
+		int which = rng.rand_int(num_params);
+		x_proposed[which] += 20.*rng.randh();
+		wrap(x_proposed[which], -10., 10.);
+	}
+	return 0.;
+}
+
+void Rosenbrock::accept_perturbation()
+{
+	x = x_proposed;
+}
+
+double Rosenbrock::log_likelihood() const
+{
+	return -f(x);
+}
+
+double Rosenbrock::proposal_log_likelihood() const
+{
+	return -f(x_proposed);
+}
+
+void Rosenbrock::get_coordinates(vector<double>& u) const
+{
+	u.resize(num_params);
+	for(int i=0; i<num_params; ++i)
+		u[i] = (x[i] + 10.)/20.;
+}
+
+void Rosenbrock::set_coordinates(const vector<double>& u)
+{
+	for(int i=0; i<num_params; ++i)
+		x[i] = -10. + 20.*u[i];
+	x_proposed = x;
+}
+
+double Rosenbrock::log_likelihood_gradient(vector<double>& gradient) const
+{
+	// d(log L)/du = -20 df/dx
+	gradient.assign(num_params, 0.);
+	for(int i=0; i+1<num_params; ++i)
+	{
+		double a = x[i+1] - x[i]*x[i];
+		gradient[i] -= -400.*x[i]*a - 2.*(1. - x[i]);
+		gradient[i+1] -= 200.*a;
+	}
+	for(double& g: gradient)
+		g *= 20.;
+	return -f(x);
+}
+
+void Rosenbrock::refine(RNG& rng)
+{
+	// Try steps along each coordinate, shrinking them when none help
+	double value = f(x);
+	for(double step = 1E-2; step > 1E-9; )
+	{
+		bool improved = false;
+		for(int k=0; k<10*num_params; ++k)
+		{
+			int which = rng.rand_int(num_params);
+			double old = x[which];
+			x[which] += step*rng.randn();
+			double new_value = f(x);
+			if(new_value < value)
+			{
+				value = new_value;
+				improved = true;
+			}
+			else
+				x[which] = old;
+		}
+		if(!improved)
+			step *= 0.5;
+	}
+	x_proposed = x;
+}
+
+void Rosenbrock::print(ostream& out) const
+{
+	for(double xi: x)
+		out<<xi<<' ';
+}
+
+void Rosenbrock::print_internal(ostream& out) const
+{
+	for(double xi: x_proposed)
+		out<<xi<<' ';
+}
+
+void Rosenbrock::read(istream& in)
+{
+	string string_repr;
+	for(double& xi: x)
+	{
+		in>>string_repr;
+		xi = strtod(string_repr.c_str(), NULL);
+	}
+}
+
+void Rosenbrock::read_internal(istream& in)
+{
+	string string_repr;
+	for(double& xi: x_proposed)
+	{
+		in>>string_repr;
+		xi = strtod(string_repr.c_str(), NULL);
+	}
+}
+
+string Rosenbrock::description() const
+{
+	stringstream s;
+	for(int i=0; i<num_params; ++i)
+		s<<"x["<<i<<"] ";
+	return s.str();
+}
+
@@ -0,0 +1,62 @@
+#ifndef DNest4_Rosenbrock
+#define DNest4_Rosenbrock
+
+#include "DNest4/code/DNest4.h"
+#include <ostream>
+#include <istream>
+#include <string>
+#include <vector>
+
+/*
+* The Rosenbrock function in a few dimensions, as a likelihood to
+* maximise. The optimum is at x = (1, 1, ..., 1) with log likelihood 0.
+*/
+class Rosenbrock
+{
+	private:
+		static const int num_params = 10;
+
+		std::vector<double> x;
+		std::vector<double> x_proposed;
+
+		static double f(const std::vector<double>& x);
+
+	public:
+		Rosenbrock();
+
+		// Generate the point from the prior
+		void from_prior(size_t i);
+
+		// Metropolis-Hastings proposals
+		double perturb(DNest4::RNG& rng);
+
+		void accept_perturbation();
+
+		// Likelihood function
+		double log_likelihood() const;
+		double proposal_log_likelihood() const;
+
+		// Coordinates in the unit hypercube, and the gradient there,
+		// for Galilean moves
+		void get_coordinates(std::vector<double>& u) const;
+		void set_coordinates(const std::vector<double>& u);
+		double log_likelihood_gradient(std::vector<double>& gradient) const;
+
+		// Local optimisation by coordinate search, for the optimiser's
+		// refinement step
+		void refine(DNest4::RNG& rng);
+
+		void read(std::istream& in);
+		// Print to stream
+		void print(std::ostream& out) const;
+
+		void read_internal(std::istream& in);
+		// Print to internal state to stream
+		void print_internal(std::ostream& out) const;
+
+		// Return string with column information
+		std::string description() const;
+};
+
+#endif
+
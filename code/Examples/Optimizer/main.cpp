@@ -0,0 +1,19 @@
+#include <iostream>
+#include "DNest4/code/DNest4.h"
+#include "Rosenbrock.h"
+
+using namespace std;
+using namespace DNest4;
+
+// Run with -O <k> to optimise (e.g. ./main -O 5 -t 4). The best
+// particle is written to best_sample.txt at the end.
+int main(int argc, char** argv)
+{
+	CommandLineOptions options(argc, argv);
+	Sampler<Rosenbrock> sampler = setup<Rosenbrock>(options);
+	sampler.set_refinement([](Rosenbrock& r, RNG& rng) { r.refine(rng); });
+	sampler.run();
+
+	return 0;
+}
+
@@ -4,14 +4,18 @@
 
 using namespace std;
 
-// The static instance
-Data Data::instance;
-
 Data::Data()
 {
 
 }
 
+Data::Data(const std::vector<double>& x, const std::vector<double>& y)
+:x(x.data(), x.size())
+,y(y.data(), y.size())
+{
+
+}
+
 void Data::load(const char* filename)
 {
 	// Vectors to hold the data
@@ -35,7 +39,7 @@ void Data::load(const char* filename)
 	fin.close();
 
 	// Copy the data to the valarrays
-	x = valarray<double>(&_x[0], _x.size());
-	y = valarray<double>(&_y[0], _y.size());
+	x = valarray<double>(_x.data(), _x.size());
+	y = valarray<double>(_y.data(), _y.size());
 }
 
@@ -2,6 +2,7 @@
 #define DNest4_Data
 
 #include <valarray>
+#include <vector>
 
 /*
 * An object of this class is a dataset
@@ -17,6 +18,9 @@ class Data
 		// Constructor
 		Data();
 
+		// Constructor: specify the data points
+		Data(const std::vector<double>& x, const std::vector<double>& y);
+
 		// Load data from a file
 		void load(const char* filename);
 
@@ -25,15 +29,6 @@ class Data
 		{ return x; }
 		const std::valarray<double>& get_y() const
 		{ return y; }
-
-	private:
-		// Static "global" instance
-		static Data instance;
-
-	public:
-		// Getter for the global instance
-		static Data& get_instance()
-		{ return instance; }
 };
 
 #endif
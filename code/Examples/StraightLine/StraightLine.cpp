@@ -5,16 +5,21 @@
 using namespace std;
 using namespace DNest4;
 
-StraightLine::StraightLine() {
+StraightLine::StraightLine()
+:data(std::make_shared<const Data>()) {
+}
+
+StraightLine::StraightLine(const std::shared_ptr<const Data>& data)
+:data(data) {
 }
 
 void StraightLine::calculate_mu() {
-    const auto &x = Data::get_instance().get_x();
+    const auto &x = data->get_x();
     mu = m * x + b;
 }
 
 void StraightLine::calculate_mu_proposed() {
-    const auto &x = Data::get_instance().get_x();
+    const auto &x = data->get_x();
     mu_proposed = m_proposed * x + b_proposed;
 }
 
@@ -81,7 +86,7 @@ void StraightLine::accept_perturbation() {
 }
 
 double StraightLine::proposal_log_likelihood() const {
-    const auto &y = Data::get_instance().get_y();
+    const auto &y = data->get_y();
 
     // Variance
     double var = sigma_proposed * sigma_proposed;
@@ -92,7 +97,7 @@ double StraightLine::proposal_log_likelihood() const {
 
 double StraightLine::log_likelihood() const {
     // Grab the y-values from the dataset
-    const auto &y = Data::get_instance().get_y();
+    const auto &y = data->get_y();
 
     // Variance
     double var = sigma * sigma;
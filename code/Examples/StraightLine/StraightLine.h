@@ -4,10 +4,15 @@
 #include "DNest4/code/DNest4.h"
 #include <valarray>
 #include <ostream>
+#include <memory>
+#include "Data.h"
 
 class StraightLine
 {
 	private:
+		// The dataset (shared between particles)
+		std::shared_ptr<const Data> data;
+
 		// The slope and intercept
 		double m, b;
 		double m_proposed, b_proposed;
@@ -25,9 +30,12 @@ class StraightLine
 		void calculate_mu_proposed();
 
 	public:
-		// Constructor
+		// Constructor: an empty dataset
 		StraightLine();
 
+		// Constructor: specify the dataset
+		explicit StraightLine(const std::shared_ptr<const Data>& data);
+
 		// Generate the point from the prior
 		void from_prior(size_t i);
 
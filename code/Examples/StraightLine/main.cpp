@@ -1,4 +1,5 @@
 #include <iostream>
+#include <memory>
 #include "Data.h"
 #include "DNest4/code/DNest4.h"
 #include "StraightLine.h"
@@ -8,9 +9,11 @@ using namespace DNest4;
 
 int main(int argc, char** argv)
 {
-	Data::get_instance().load("road");
+	auto data = std::make_shared<Data>();
+	data->load("road");
     CommandLineOptions options(argc, argv);
-    Sampler<StraightLine> sampler = setup<StraightLine>(options, false);
+    Sampler<StraightLine> sampler = setup<StraightLine>(options,
+                                                StraightLine(data), false);
     sampler.run();
 
 	return 0;
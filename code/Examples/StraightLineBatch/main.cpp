@@ -0,0 +1,55 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Data.h"
+#include "DNest4/code/DNest4.h"
+#include "StraightLine.h"
+
+using namespace std;
+using namespace DNest4;
+
+// Number of independent inferences to run
+const int num_jobs = 16;
+
+int main(int argc, char** argv)
+{
+    // -t sets the number of threads shared by all jobs
+    CommandLineOptions options(argc, argv);
+    Options sampler_options(options.get_options_file().c_str());
+
+    // Each job gets its own bootstrap resample of the road data,
+    // standing in for one object of a catalogue
+    Data road;
+    road.load("../StraightLine/road");
+    RNG rng(options.get_seed_uint());
+
+    Batch<StraightLine> batch(options.get_num_threads());
+    for(int i=0; i<num_jobs; ++i)
+    {
+        vector<double> x, y;
+        for(size_t j=0; j<road.get_x().size(); ++j)
+        {
+            int k = rng.rand_int(road.get_x().size());
+            x.push_back(road.get_x()[k]);
+            y.push_back(road.get_y()[k]);
+        }
+        auto data = make_shared<const Data>(x, y);
+
+        // Each job writes its own output files
+        Options job_options = sampler_options;
+        job_options.prefix_filenames("job" + to_string(i) + "_");
+
+        batch.add_job(StraightLine(data), job_options,
+                      options.get_compression_double(),
+                      options.get_seed_uint() + i);
+    }
+
+    // This program owns the process, so checkpoint every job on SIGTERM
+    batch.handle_sigterm(options.get_drain_deadline());
+    batch.run();
+    batch.print_throughput(cout);
+
+    return 0;
+}
+
@@ -0,0 +1,170 @@
+#ifndef DNest4_GalileanMove
+#define DNest4_GalileanMove
+
+#include <cmath>
+#include <vector>
+#include "LikelihoodType.h"
+#include "ModelTraits.h"
+#include "RNG.h"
+
+namespace DNest4
+{
+
+/*
+* Galilean Monte Carlo (Skilling, 2012) inside a level. The particle
+* moves in straight lines through the unit hypercube, reflecting off its
+* walls and off the level's likelihood threshold (using the likelihood
+* gradient there), which mixes far better than random walks in many
+* dimensions. Needs the gradient interface described in ModelTraits.h.
+*/
+template<class ModelType, bool = has_gradient<ModelType>::value>
+class GalileanMove
+{
+	public:
+		static bool available()
+		{ return false; }
+
+		static bool move(ModelType&, LikelihoodType&, const LikelihoodType&,
+						unsigned int, double&, double, bool, RNG&,
+						unsigned long long int&)
+		{ return false; }
+};
+
+template<class ModelType>
+class GalileanMove<ModelType, true>
+{
+	private:
+		// Put u back inside [0, 1], bouncing v off the walls
+		static void reflect_walls(std::vector<double>& u,
+									std::vector<double>& v)
+		{
+			for(size_t i=0; i<u.size(); ++i)
+			{
+				u[i] = std::fmod(u[i], 2.);
+				if(u[i] < 0.)
+					u[i] += 2.;
+				if(u[i] > 1.)
+				{
+					u[i] = 2. - u[i];
+					v[i] = -v[i];
+				}
+			}
+		}
+
+		static double evaluate(ModelType& particle, const std::vector<double>& u,
+								unsigned long long int& count_evaluations)
+		{
+			particle.set_coordinates(u);
+			++count_evaluations;
+			return particle.log_likelihood();
+		}
+
+	public:
+		static bool available()
+		{ return true; }
+
+		// Do a trajectory of num_steps steps, keeping the particle above
+		// 'threshold'. If 'adapt', the step size exp(log_step) is adapted
+		// so that a fraction 'target' of steps go straight. Returns whether
+		// the particle moved.
+		static bool move(ModelType& particle, LikelihoodType& logl,
+						const LikelihoodType& threshold,
+						unsigned int num_steps, double& log_step,
+						double target, bool adapt, RNG& rng,
+						unsigned long long int& count_evaluations)
+		{
+			std::vector<double> u, u_new, v, gradient;
+			particle.get_coordinates(u);
+			const double tiebreaker = logl.get_tiebreaker();
+			double log_likelihood = logl.get_value();
+
+			// Random direction and speed
+			double step = std::exp(log_step);
+			v.resize(u.size());
+			for(double& vi: v)
+				vi = step*rng.randn();
+
+			unsigned int straight = 0;
+			bool moved = false;
+			for(unsigned int k=0; k<num_steps; ++k)
+			{
+				u_new = u;
+				std::vector<double> v_new = v;
+				for(size_t i=0; i<u.size(); ++i)
+					u_new[i] += v[i];
+				reflect_walls(u_new, v_new);
+
+				double logl_new = evaluate(particle, u_new, count_evaluations);
+				if(threshold < LikelihoodType(logl_new, tiebreaker))
+				{
+					u = u_new;
+					v = v_new;
+					log_likelihood = logl_new;
+					moved = true;
+					++straight;
+					continue;
+				}
+
+				// Outside: bounce off the contour through u_new
+				particle.log_likelihood_gradient(gradient);
+				++count_evaluations;
+				double g2 = 0., vg = 0.;
+				for(size_t i=0; i<u.size(); ++i)
+				{
+					g2 += gradient[i]*gradient[i];
+					vg += v_new[i]*gradient[i];
+				}
+				if(g2 > 0.)
+				{
+					for(size_t i=0; i<u.size(); ++i)
+						v_new[i] -= 2.*vg/g2*gradient[i];
+				}
+				for(size_t i=0; i<u.size(); ++i)
+					u_new[i] += v_new[i];
+				reflect_walls(u_new, v_new);
+
+				logl_new = evaluate(particle, u_new, count_evaluations);
+				if(threshold < LikelihoodType(logl_new, tiebreaker))
+				{
+					u = u_new;
+					v = v_new;
+					log_likelihood = logl_new;
+					moved = true;
+				}
+				else
+				{
+					// Stuck: turn around
+					for(double& vi: v)
+						vi = -vi;
+				}
+			}
+
+			// Leave the particle where the trajectory ended
+			particle.set_coordinates(u);
+
+			// Perturb the tiebreaker, as for any other move
+			LikelihoodType logl_new(log_likelihood, tiebreaker);
+			logl_new.perturb(rng);
+			if(threshold < logl_new)
+				logl = logl_new;
+			else
+				logl = LikelihoodType(log_likelihood, tiebreaker);
+
+			// Adapt the step size for this level. Steps can't usefully be
+			// longer than the hypercube.
+			if(adapt)
+			{
+				log_step += 0.1*(static_cast<double>(straight)/num_steps
+									- target);
+				if(log_step > 0.)
+					log_step = 0.;
+			}
+
+			return moved;
+		}
+};
+
+} // namespace DNest4
+
+#endif
+
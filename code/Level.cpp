@@ -1,6 +1,9 @@
 #include "Level.h"
 #include <cassert>
 #include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
 
 using namespace std;
 
@@ -57,6 +60,74 @@ void Level::renormalise_visits(vector<Level>& levels,
 	}
 }
 
+bool Level::enough_levels(const vector<Level>& levels,
+							unsigned int max_num_levels)
+{
+	if(max_num_levels == 0)
+	{
+		// Check level spacing (in terms of log likelihood)
+		// over last n levels
+		int num_levels_to_check = static_cast<int>(30*sqrt(0.02*levels.size()));
+		if(num_levels_to_check < 30)
+			return false;
+
+		int k = levels.size() - 1;
+		double tot = 0.0;
+		double max = -1E300;
+		for(int i=0; i<num_levels_to_check; ++i)
+		{
+			double diff = levels[k].get_log_likelihood().get_value()
+							- levels[k-1].get_log_likelihood().get_value();
+			tot += diff;
+			if(diff > max)
+				max = diff;
+			--k;
+		}
+		return (tot / num_levels_to_check < 0.75 && max < 1.0);
+	}
+
+	// Just compare with the value from OPTIONS
+	return (levels.size() >= max_num_levels);
+}
+
+vector<Level> Level::load_levels(const char* filename)
+{
+	vector<Level> levels;
+
+	fstream fin(filename, ios::in);
+	if(!fin)
+		return levels;
+
+	// Read past comment lines at the top of the file
+	while(fin.peek() == '#')
+		fin.ignore(1000000, '\n');
+
+	// Columns are log_X, log_likelihood, tiebreaker,
+	// accepts, tries, exceeds, visits
+	string line;
+	while(getline(fin, line))
+	{
+		stringstream s(line);
+		string log_X_str;
+		if(!(s>>log_X_str))
+			continue;
+
+		Level level;
+		level.log_likelihood.read(s);
+		level.log_X = strtod(log_X_str.c_str(), NULL);
+		s>>level.accepts>>level.tries>>level.exceeds>>level.visits;
+
+		// The bottom level is always the prior
+		if(levels.size() == 0)
+			level.log_likelihood = LikelihoodType();
+
+		levels.push_back(level);
+	}
+	fin.close();
+
+	return levels;
+}
+
 void Level::print(ostream& out) const
 {
 	log_likelihood.print(out);
@@ -68,6 +68,14 @@ class Level
 										unsigned int regularisation);
 		static void renormalise_visits(std::vector<Level>& levels,
 										unsigned int regularisation);
+
+		// Whether a ladder is complete. If max_num_levels is zero,
+		// decide from the spacing of the top levels.
+		static bool enough_levels(const std::vector<Level>& levels,
+									unsigned int max_num_levels);
+
+		// Load the levels from a levels.txt file written by a sampler
+		static std::vector<Level> load_levels(const char* filename);
 };
 
 } // namespace DNest4
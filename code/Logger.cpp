@@ -0,0 +1,319 @@
+#include "Logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+
+#ifndef NO_THREADS
+#include <thread>
+#endif
+
+namespace DNest4
+{
+
+/*
+* Writes the lines queued by every logger, in order. With threads, that's
+* done by a background thread started with the first line, and stopped
+* (after writing what's left) when the program exits.
+*/
+class Logger::Writer
+{
+	private:
+		struct Entry
+		{
+			LogLevel level;
+			std::string text;
+			std::shared_ptr<const Sinks> sinks;
+		};
+
+		std::mutex mutex;
+		std::condition_variable wake, written;
+		std::vector<Entry> queue;
+		unsigned long long int num_queued, num_written;
+#ifndef NO_THREADS
+		bool stopping;
+		std::thread thread;
+
+		void write_loop();
+#endif
+
+		// Write some lines, flushing each stream written to once
+		static void write(const std::vector<Entry>& batch);
+
+		Writer();
+
+	public:
+		~Writer();
+
+		static Writer& instance();
+
+		// Queue a line, returning its number
+		unsigned long long int enqueue(LogLevel level, std::string&& text,
+									const std::shared_ptr<const Sinks>& sinks);
+
+		// Wait until line number 'which' has been written
+		void wait(unsigned long long int which);
+};
+
+Logger::Writer::Writer()
+:num_queued(0)
+,num_written(0)
+#ifndef NO_THREADS
+,stopping(false)
+#endif
+{
+
+}
+
+Logger::Writer::~Writer()
+{
+#ifndef NO_THREADS
+	std::unique_lock<std::mutex> lock(mutex);
+	stopping = true;
+	wake.notify_all();
+	lock.unlock();
+
+	if(thread.joinable())
+		thread.join();
+#endif
+}
+
+Logger::Writer& Logger::Writer::instance()
+{
+	static Writer writer;
+	return writer;
+}
+
+unsigned long long int Logger::Writer::enqueue(LogLevel level,
+									std::string&& text,
+									const std::shared_ptr<const Sinks>& sinks)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+#ifndef NO_THREADS
+	if(!thread.joinable())
+		thread = std::thread(&Writer::write_loop, this);
+
+	queue.push_back({level, std::move(text), sinks});
+	wake.notify_one();
+	return ++num_queued;
+#else
+	write(std::vector<Entry>{{level, std::move(text), sinks}});
+	num_written = ++num_queued;
+	return num_queued;
+#endif
+}
+
+void Logger::Writer::wait(unsigned long long int which)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	written.wait(lock, [&]{ return num_written >= which; });
+}
+
+#ifndef NO_THREADS
+void Logger::Writer::write_loop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true)
+	{
+		wake.wait(lock, [this]{ return !queue.empty() || stopping; });
+		if(queue.empty())
+			break;
+
+		std::vector<Entry> batch;
+		batch.swap(queue);
+		lock.unlock();
+
+		write(batch);
+
+		lock.lock();
+		num_written += batch.size();
+		written.notify_all();
+	}
+}
+#endif
+
+void Logger::Writer::write(const std::vector<Entry>& batch)
+{
+	std::vector<std::ostream*> used;
+	for(const auto& entry: batch)
+	{
+		for(const auto& sink: *entry.sinks)
+		{
+			if(entry.level >= sink.min && entry.level <= sink.max)
+			{
+				*sink.out << entry.text << '\n';
+				if(std::find(used.begin(), used.end(), sink.out) == used.end())
+					used.push_back(sink.out);
+			}
+		}
+	}
+	for(std::ostream* out: used)
+		out->flush();
+}
+
+Logger::Logger()
+:level(LogLevel::info)
+,sinks(std::make_shared<const Sinks>())
+,rate_count(10)
+,rate_seconds(1.)
+,last_queued(0)
+{
+	// Made first, so that it outlives loggers with static storage
+	Writer::instance();
+
+	add_sink(std::cout, LogLevel::debug, LogLevel::info);
+	add_sink(std::cerr, LogLevel::warning, LogLevel::error);
+}
+
+Logger::~Logger()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for(auto& window: windows)
+		summarise(window.first, window.second);
+	lock.unlock();
+
+	// The sinks may not outlive this
+	flush();
+}
+
+void Logger::set_level(LogLevel level)
+{
+	this->level = level;
+}
+
+void Logger::add_sink(std::ostream& out, LogLevel min, LogLevel max)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto new_sinks = std::make_shared<Sinks>(*sinks);
+	new_sinks->push_back({&out, nullptr, min, max});
+	sinks = new_sinks;
+}
+
+void Logger::add_file(const std::string& filename, LogLevel min, LogLevel max)
+{
+	auto file = std::make_shared<std::ofstream>(filename, std::ios::app);
+	if(!file->is_open())
+	{
+		std::cerr << "error opening log file " << filename << ". Continuing";
+		std::cerr << std::endl;
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	auto new_sinks = std::make_shared<Sinks>(*sinks);
+	new_sinks->push_back({file.get(), file, min, max});
+	sinks = new_sinks;
+}
+
+void Logger::clear_sinks()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	sinks = std::make_shared<const Sinks>();
+}
+
+void Logger::set_rate_limit(unsigned int count, double seconds)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	rate_count = count;
+	rate_seconds = seconds;
+}
+
+void Logger::log(LogLevel level, const std::string& text, const char* category)
+{
+	if(!enabled(level))
+		return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(category != nullptr && rate_count > 0)
+	{
+		auto now = std::chrono::steady_clock::now();
+		Window& window = windows[category];
+		if(window.count == 0 ||
+			std::chrono::duration<double>(now - window.start).count()
+															>= rate_seconds)
+		{
+			summarise(category, window);
+			window.start = now;
+			window.count = 0;
+		}
+		if(window.count >= rate_count)
+		{
+			++window.suppressed;
+			return;
+		}
+		++window.count;
+	}
+	enqueue(level, std::string(text));
+}
+
+LogLine Logger::debug(const char* category)
+{
+	return LogLine(this, LogLevel::debug, category);
+}
+
+LogLine Logger::info(const char* category)
+{
+	return LogLine(this, LogLevel::info, category);
+}
+
+LogLine Logger::warning(const char* category)
+{
+	return LogLine(this, LogLevel::warning, category);
+}
+
+LogLine Logger::error(const char* category)
+{
+	return LogLine(this, LogLevel::error, category);
+}
+
+void Logger::flush()
+{
+	unsigned long long int which;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		which = last_queued;
+	}
+	Writer::instance().wait(which);
+}
+
+void Logger::enqueue(LogLevel level, std::string&& text)
+{
+	last_queued = Writer::instance().enqueue(level, std::move(text), sinks);
+}
+
+void Logger::summarise(const std::string& category, Window& window)
+{
+	if(window.suppressed == 0)
+		return;
+
+	std::stringstream s;
+	s << "# Suppressed " << window.suppressed << " more \"" << category;
+	s << "\" message" << ((window.suppressed > 1)?("s"):("")) << ".";
+	window.suppressed = 0;
+	enqueue(LogLevel::info, s.str());
+}
+
+LogLine::LogLine(Logger* logger, LogLevel level, const char* category)
+:logger((logger != nullptr && logger->enabled(level))?(logger):(nullptr))
+,level(level)
+,category(category)
+{
+	stream << std::scientific << std::setprecision(16);
+}
+
+LogLine::LogLine(LogLine&& other)
+:logger(other.logger)
+,level(other.level)
+,category(other.category)
+,stream(std::move(other.stream))
+{
+	other.logger = nullptr;
+}
+
+LogLine::~LogLine()
+{
+	if(logger != nullptr)
+		logger->log(level, stream.str(), category);
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,153 @@
+#ifndef DNest4_Logger
+#define DNest4_Logger
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace DNest4
+{
+
+enum class LogLevel
+{
+	debug, info, warning, error, off
+};
+
+class LogLine;
+
+/*
+* A sampler's messages. Lines are queued and written by one background
+* thread shared by every logger in the process, which flushes once per
+* batch rather than once per line, so a slow stdout (e.g. on a network
+* file system) doesn't stall the sampler. Compiled with -DNO_THREADS,
+* lines are written at once instead. Each line goes to every sink whose
+* range of levels includes it. By default, info goes to std::cout and
+* warnings and errors to std::cerr. Messages given a category are rate
+* limited, and those dropped are summarised in one line later.
+*/
+class Logger
+{
+	private:
+		struct Sink
+		{
+			std::ostream* out;
+			std::shared_ptr<std::ofstream> file;
+			LogLevel min, max;
+		};
+		typedef std::vector<Sink> Sinks;
+
+		// The process-wide writer (see Logger.cpp)
+		class Writer;
+
+		// Rate limiting of one category
+		struct Window
+		{
+			std::chrono::steady_clock::time_point start;
+			unsigned int count;
+			unsigned long long int suppressed;
+		};
+
+		std::atomic<LogLevel> level;
+
+		// Replaced rather than changed, so lines already queued still go
+		// where they were meant to
+		std::shared_ptr<const Sinks> sinks;
+
+		// At most 'rate_count' messages per 'rate_seconds' per category
+		// (no limit if zero)
+		unsigned int rate_count;
+		double rate_seconds;
+		std::map<std::string, Window> windows;
+
+		std::mutex mutex;
+
+		// The writer's number for the last line queued by this logger
+		unsigned long long int last_queued;
+
+		void enqueue(LogLevel level, std::string&& text);
+		void summarise(const std::string& category, Window& window);
+
+	public:
+		Logger();
+		~Logger();
+
+		Logger(const Logger& other) = delete;
+		Logger& operator = (const Logger& other) = delete;
+
+		// Drop messages below this level (default info)
+		void set_level(LogLevel level);
+		bool enabled(LogLevel level) const
+		{ return level >= this->level && level != LogLevel::off; }
+
+		// Send messages from 'min' to 'max' to 'out', which must outlive
+		// the logger, or append them to a file
+		void add_sink(std::ostream& out, LogLevel min=LogLevel::debug,
+						LogLevel max=LogLevel::error);
+		void add_file(const std::string& filename,
+						LogLevel min=LogLevel::debug,
+						LogLevel max=LogLevel::error);
+		void clear_sinks();
+
+		// Allow 'count' messages of each category per 'seconds' (0 for no
+		// limit; the default is 10 per second)
+		void set_rate_limit(unsigned int count, double seconds=1.);
+
+		// Queue one line. Messages without a category are never dropped.
+		void log(LogLevel level, const std::string& text,
+				const char* category=nullptr);
+
+		// Build a line with <<, queued when the LogLine goes away
+		LogLine debug(const char* category=nullptr);
+		LogLine info(const char* category=nullptr);
+		LogLine warning(const char* category=nullptr);
+		LogLine error(const char* category=nullptr);
+
+		// Wait until everything this logger has queued has been written
+		void flush();
+};
+
+/*
+* One line being built. Numbers are written in the same format as the
+* sampler's output files (scientific, 16 digits) unless changed with
+* manipulators, which only affect this line.
+*/
+class LogLine
+{
+	private:
+		Logger* logger;
+		LogLevel level;
+		const char* category;
+		std::ostringstream stream;
+
+	public:
+		LogLine(Logger* logger, LogLevel level, const char* category);
+		LogLine(LogLine&& other);
+		~LogLine();
+
+		template<class T>
+		LogLine& operator << (const T& x)
+		{
+			if(logger != nullptr)
+				stream << x;
+			return *this;
+		}
+
+		LogLine& operator << (std::ios_base& (*manipulator)(std::ios_base&))
+		{
+			if(logger != nullptr)
+				stream << manipulator;
+			return *this;
+		}
+};
+
+} // namespace DNest4
+
+#endif
+
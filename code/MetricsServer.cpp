@@ -0,0 +1,88 @@
+#include "MetricsServer.h"
+#include <sstream>
+
+namespace DNest4
+{
+
+MetricsServer::MetricsServer(const std::string& address)
+:listener(Socket::listen_local(address))
+,stopping(false)
+{
+	// A path is ours to remove only once we have a socket there
+	std::string host;
+	unsigned short port;
+	if(listener.is_open())
+	{
+		if(!parse_address(address, host, port))
+			socket_path = address;
+		thread = std::thread(&MetricsServer::serve, this);
+	}
+}
+
+MetricsServer::~MetricsServer()
+{
+	stopping = true;
+	if(thread.joinable())
+		thread.join();
+	listener.close();
+	if(socket_path != "")
+		remove_socket_file(socket_path);
+}
+
+void MetricsServer::publish(const std::string& text)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	snapshot = text;
+}
+
+void MetricsServer::serve()
+{
+	while(!stopping)
+	{
+		// Wake up now and then to see if it's time to stop
+		if(!listener.wait_readable(200))
+			continue;
+
+		Socket connection = listener.accept();
+		if(connection.is_open())
+			respond(connection);
+	}
+}
+
+void MetricsServer::respond(Socket& connection)
+{
+	// Read the request headers, giving up on clients that are too slow
+	std::string request, chunk;
+	while(request.find("\r\n\r\n") == std::string::npos &&
+			request.find("\n\n") == std::string::npos &&
+			request.size() < 8192)
+	{
+		if(stopping || !connection.wait_readable(1000) ||
+			!connection.receive_text(chunk))
+			return;
+		request += chunk;
+	}
+
+	std::string body;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		body = snapshot;
+	}
+
+	std::stringstream response;
+	if(request.compare(0, 4, "GET ") == 0)
+	{
+		response << "HTTP/1.0 200 OK\r\n";
+		response << "Content-Type: text/plain; version=0.0.4\r\n";
+		response << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+	}
+	else
+	{
+		response << "HTTP/1.0 405 Method Not Allowed\r\n";
+		response << "Content-Length: 0\r\n\r\n";
+	}
+	connection.send_text(response.str());
+}
+
+} // namespace DNest4
+
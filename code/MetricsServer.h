@@ -0,0 +1,59 @@
+#ifndef DNest4_MetricsServer
+#define DNest4_MetricsServer
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Socket.h"
+
+namespace DNest4
+{
+
+/*
+* Serves the latest metrics (Prometheus text) over HTTP on this machine,
+* from a background thread. The sampler only swaps in a new snapshot
+* under a mutex, so a slow or stuck scraper never holds up the MCMC.
+*/
+class MetricsServer
+{
+	private:
+		Socket listener;
+
+		// Where the Unix socket is, if listening on one
+		std::string socket_path;
+
+		std::mutex mutex;
+		std::string snapshot;
+
+		std::atomic<bool> stopping;
+		std::thread thread;
+
+		// Answer requests until stopping
+		void serve();
+
+		// Answer one request
+		void respond(Socket& connection);
+
+	public:
+		// Listen on a loopback port ("port" or "localhost:port") or a Unix
+		// socket (any address that isn't host:port is taken as its path).
+		// A non-local host, or a path holding anything but a socket,
+		// leaves it not listening.
+		explicit MetricsServer(const std::string& address);
+		~MetricsServer();
+
+		MetricsServer(const MetricsServer& other) = delete;
+		MetricsServer& operator = (const MetricsServer& other) = delete;
+
+		bool is_listening() const
+		{ return listener.is_open(); }
+
+		// Replace what is served
+		void publish(const std::string& text);
+};
+
+} // namespace DNest4
+
+#endif
+
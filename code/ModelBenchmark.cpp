@@ -0,0 +1,47 @@
+#include "ModelBenchmark.h"
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+namespace DNest4
+{
+
+unsigned long long int (*count_allocations)() = nullptr;
+
+const OperationCost& ModelCost::get(const std::string& name) const
+{
+	for(const auto& operation: operations)
+		if(operation.name == name)
+			return operation;
+	throw std::runtime_error("no operation called " + name + ".");
+}
+
+void ModelCost::print(std::ostream& out) const
+{
+	out << "# operation, calls, microseconds per call, ";
+	out << "heap allocations per call" << std::endl;
+	for(const auto& operation: operations)
+	{
+		out << operation.name << ' ' << operation.calls << ' ';
+		out << std::fixed << std::setprecision(3) << 1E6*operation.seconds;
+		out << ' ';
+		if(std::isnan(operation.allocations))
+			out << '-';
+		else
+			out << std::setprecision(2) << operation.allocations;
+		out << std::endl;
+	}
+
+	out << "# Bytes per particle in the sample file: " << sample_bytes;
+	out << ", in a checkpoint: " << checkpoint_bytes << '.' << std::endl;
+	if(!checkpoint_round_trip)
+		out << "# Warning: reading a checkpointed particle and printing it "
+			<< "again gives different output." << std::endl;
+	out << "# Likelihood computed after " << std::setprecision(1);
+	out << 100.*fraction_evaluated << "% of perturb() calls." << std::endl;
+	out << "# At most " << std::setprecision(0) << steps_per_second;
+	out << " MCMC steps per second per thread." << std::endl;
+}
+
+} // namespace DNest4
+
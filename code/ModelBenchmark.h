@@ -0,0 +1,73 @@
+#ifndef DNest4_ModelBenchmark
+#define DNest4_ModelBenchmark
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace DNest4
+{
+
+/*
+* What a ModelType costs per operation, measured by calling its methods
+* directly rather than by running a Sampler. Heap allocations are only
+* counted if the program includes AllocationCounting.h (in one source
+* file), and only those made on the calling thread.
+*/
+
+// Heap allocations made so far by the calling thread, or nullptr if
+// AllocationCounting.h is not part of the program
+extern unsigned long long int (*count_allocations)();
+
+// Mean cost of one call to one of the model's methods
+struct OperationCost
+{
+	std::string name;
+	unsigned int calls;
+	double seconds;
+
+	// NaN if allocations aren't being counted
+	double allocations;
+};
+
+struct ModelCost
+{
+	std::vector<OperationCost> operations;
+
+	// Size of a particle in the sample file (print()) and in a
+	// checkpoint (print() and print_internal(), in hexadecimal)
+	size_t sample_bytes;
+	size_t checkpoint_bytes;
+
+	// Whether reading a checkpointed particle and writing it out again
+	// gives the same text
+	bool checkpoint_round_trip;
+
+	// Fraction of perturb() calls whose Hastings factor lets the
+	// likelihood be computed, while moving through the prior
+	double fraction_evaluated;
+
+	// Best case for one thread: perturb(), then the likelihood and
+	// accept_perturbation() as often as the Hastings factor allows,
+	// without any of the sampler's own work
+	double steps_per_second;
+
+	// Look up an operation by name (throws if there is none)
+	const OperationCost& get(const std::string& name) const;
+
+	// A table of the operations, then the sizes and the estimate
+	void print(std::ostream& out) const;
+};
+
+// Time 'num_calls' calls of each of the model's methods on copies of
+// 'prototype', drawing them from the prior with from_prior(seed + i)
+template<class ModelType>
+ModelCost benchmark_model(const ModelType& prototype=ModelType(),
+							unsigned int num_calls=1000,
+							unsigned int seed=0);
+
+} // namespace DNest4
+
+#include "ModelBenchmarkImpl.h"
+#endif
+
@@ -0,0 +1,161 @@
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <streambuf>
+#include "RNG.h"
+
+namespace DNest4
+{
+
+// A stream buffer which only counts what is written to it, so printing
+// allocates nothing on the model's behalf
+class CountingBuffer : public std::streambuf
+{
+	private:
+		size_t count;
+
+	protected:
+		int_type overflow(int_type c)
+		{
+			if(!traits_type::eq_int_type(c, traits_type::eof()))
+				++count;
+			return traits_type::not_eof(c);
+		}
+
+		std::streamsize xsputn(const char*, std::streamsize n)
+		{
+			count += n;
+			return n;
+		}
+
+	public:
+		CountingBuffer() :count(0) { }
+		size_t get_count() const { return count; }
+		void reset() { count = 0; }
+};
+
+// Time 'operation(i)' for each call i, after an untimed 'setup(i)'
+template<class Setup, class Operation>
+OperationCost time_operation(const std::string& name, unsigned int num_calls,
+							Setup setup, Operation operation)
+{
+	typedef std::chrono::steady_clock clock;
+
+	OperationCost cost;
+	cost.name = name;
+	cost.calls = num_calls;
+
+	double seconds = 0.;
+	unsigned long long int allocations = 0;
+	for(unsigned int i=0; i<num_calls; ++i)
+	{
+		setup(i);
+		unsigned long long int before = (count_allocations)?(count_allocations()):(0);
+		auto start = clock::now();
+		operation(i);
+		auto end = clock::now();
+		if(count_allocations)
+			allocations += count_allocations() - before;
+		seconds += std::chrono::duration<double>(end - start).count();
+	}
+
+	cost.seconds = seconds/num_calls;
+	cost.allocations = (count_allocations)?((double)allocations/num_calls)
+											:(std::nan(""));
+	return cost;
+}
+
+template<class ModelType>
+ModelCost benchmark_model(const ModelType& prototype, unsigned int num_calls,
+							unsigned int seed)
+{
+	assert(num_calls > 0);
+
+	ModelCost result;
+	RNG rng(seed);
+	ModelType particle = prototype;
+	particle.from_prior(seed);
+
+	// Keep the results alive so the calls aren't optimised away
+	volatile double sink = 0.;
+	auto nothing = [](unsigned int) { };
+
+	result.operations.push_back(time_operation("from_prior", num_calls,
+		nothing,
+		[&](unsigned int i) { particle.from_prior(seed + i); }));
+
+	unsigned int num_evaluated = 0;
+	result.operations.push_back(time_operation("perturb", num_calls,
+		nothing,
+		[&](unsigned int) {
+			double log_H = particle.perturb(rng);
+			if(rng.rand() <= exp(log_H))
+				++num_evaluated;
+		}));
+	result.fraction_evaluated = (double)num_evaluated/num_calls;
+
+	auto perturb = [&](unsigned int) { particle.perturb(rng); };
+	result.operations.push_back(time_operation("proposal_log_likelihood",
+		num_calls, perturb,
+		[&](unsigned int) { sink = particle.proposal_log_likelihood(); }));
+
+	result.operations.push_back(time_operation("log_likelihood", num_calls,
+		nothing,
+		[&](unsigned int) { sink = particle.log_likelihood(); }));
+
+	result.operations.push_back(time_operation("accept_perturbation",
+		num_calls, perturb,
+		[&](unsigned int) { particle.accept_perturbation(); }));
+
+	// Output, formatted as in the sample file and in checkpoints
+	CountingBuffer buffer;
+	std::ostream out(&buffer);
+	out << std::scientific << std::setprecision(16);
+	result.operations.push_back(time_operation("print", num_calls,
+		[&](unsigned int) { buffer.reset(); },
+		[&](unsigned int) { particle.print(out); }));
+	result.sample_bytes = buffer.get_count();
+
+	out << std::hexfloat;
+	result.operations.push_back(time_operation("checkpoint_print", num_calls,
+		[&](unsigned int) { buffer.reset(); },
+		[&](unsigned int) {
+			particle.print(out);
+			particle.print_internal(out);
+		}));
+	result.checkpoint_bytes = buffer.get_count();
+
+	std::stringstream checkpoint;
+	checkpoint << std::hexfloat;
+	particle.print(checkpoint);
+	particle.print_internal(checkpoint);
+	const std::string text = checkpoint.str();
+
+	ModelType copy = prototype;
+	std::istringstream in;
+	result.operations.push_back(time_operation("checkpoint_read", num_calls,
+		[&](unsigned int) { in.clear(); in.str(text); },
+		[&](unsigned int) {
+			copy.read(in);
+			copy.read_internal(in);
+		}));
+
+	std::stringstream again;
+	again << std::hexfloat;
+	copy.print(again);
+	copy.print_internal(again);
+	result.checkpoint_round_trip = (again.str() == text);
+
+	double step = result.get("perturb").seconds
+				+ result.fraction_evaluated
+					*(result.get("proposal_log_likelihood").seconds
+						+ result.get("accept_perturbation").seconds);
+	result.steps_per_second = 1./step;
+
+	return result;
+}
+
+} // namespace DNest4
+
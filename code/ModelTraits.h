@@ -0,0 +1,89 @@
+#ifndef DNest4_ModelTraits
+#define DNest4_ModelTraits
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace DNest4
+{
+
+/*
+* Optional parts of the model interface, detected at compile time so
+* that models without them still work with every sampler feature they
+* don't use.
+*
+* Coordinates: the model's parameters as a point in the unit hypercube,
+* where the prior is uniform.
+*     void get_coordinates(std::vector<double>& u) const;
+*     void set_coordinates(const std::vector<double>& u);
+* set_coordinates must leave log_likelihood() valid for the new point.
+*
+* Gradient: in addition, the log likelihood and its gradient with respect
+* to the unit hypercube coordinates, at the current point.
+*     double log_likelihood_gradient(std::vector<double>& gradient) const;
+*
+* Surrogate: a cheap approximation to the log likelihood (a coarse grid,
+* a subset of the data, an emulator) at the current and proposed points,
+* used to screen proposals before the exact likelihood is computed.
+*     double approx_log_likelihood() const;
+*     double proposal_approx_log_likelihood() const;
+*/
+template<class ModelType>
+class has_coordinates
+{
+	private:
+		template<class T>
+		static auto test(int) -> decltype(
+			std::declval<const T&>().get_coordinates(
+									std::declval<std::vector<double>&>()),
+			std::declval<T&>().set_coordinates(
+									std::declval<const std::vector<double>&>()),
+			std::true_type());
+
+		template<class T>
+		static std::false_type test(...);
+
+	public:
+		static const bool value = decltype(test<ModelType>(0))::value;
+};
+
+template<class ModelType>
+class has_gradient
+{
+	private:
+		template<class T>
+		static auto test(int) -> decltype(
+			std::declval<const T&>().log_likelihood_gradient(
+									std::declval<std::vector<double>&>()),
+			std::true_type());
+
+		template<class T>
+		static std::false_type test(...);
+
+	public:
+		static const bool value = has_coordinates<ModelType>::value &&
+								decltype(test<ModelType>(0))::value;
+};
+
+template<class ModelType>
+class has_approx_log_likelihood
+{
+	private:
+		template<class T>
+		static auto test(int) -> decltype(
+			std::declval<const T&>().approx_log_likelihood(),
+			std::declval<const T&>().proposal_approx_log_likelihood(),
+			std::true_type());
+
+		template<class T>
+		static std::false_type test(...);
+
+	public:
+		static const bool value = decltype(test<ModelType>(0))::value;
+};
+
+} // namespace DNest4
+
+#endif
+
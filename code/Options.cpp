@@ -42,6 +42,8 @@ Options::Options(const char* filename)
 ,sample_info_file("sample_info.txt")
 ,levels_file("levels.txt")
 ,checkpoint_file("sampler_state.txt")
+,best_particle_file("best_sample.txt")
+,best_likelihood_file("best_likelihood.txt")
 {
 	load(filename);
 }
@@ -82,6 +84,16 @@ void Options::load(const char* filename)
 			beta >= 0.);
 }
 
+void Options::prefix_filenames(const std::string& prefix)
+{
+	sample_file = prefix + sample_file;
+	sample_info_file = prefix + sample_info_file;
+	levels_file = prefix + levels_file;
+	checkpoint_file = prefix + checkpoint_file;
+	best_particle_file = prefix + best_particle_file;
+	best_likelihood_file = prefix + best_likelihood_file;
+}
+
 void Options::print(std::ostream& out) const
 {
 	out<<num_particles<<' ';
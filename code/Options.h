@@ -29,6 +29,9 @@ class Options
 		Options(const char* filename);
 		void load(const char* filename);
 
+		// Prepend 'prefix' to all of the output filenames
+		void prefix_filenames(const std::string& prefix);
+
 		void print(std::ostream& out) const;
 		void read(std::istream& in);
 
@@ -0,0 +1,40 @@
+#include "Parallel.h"
+#include <algorithm>
+
+namespace DNest4
+{
+
+size_t chunk_size(size_t n, size_t grain)
+{
+	if(grain > 0)
+		return grain;
+	return std::max<size_t>((n + 63)/64, 1);
+}
+
+void parallel_for(size_t begin, size_t end,
+					const std::function<void(size_t, size_t)>& body,
+					size_t grain)
+{
+	if(end <= begin)
+		return;
+
+	size_t size = chunk_size(end - begin, grain);
+	size_t num_chunks = (end - begin + size - 1)/size;
+	auto run_chunk = [&](size_t i)
+	{
+		size_t b = begin + i*size;
+		body(b, std::min(b + size, end));
+	};
+
+	ThreadPool* pool = ThreadPool::current();
+	if(pool == nullptr || num_chunks == 1)
+	{
+		for(size_t i=0; i<num_chunks; ++i)
+			run_chunk(i);
+	}
+	else
+		pool->parallel_for(num_chunks, run_chunk);
+}
+
+} // namespace DNest4
+
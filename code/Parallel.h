@@ -0,0 +1,67 @@
+#ifndef DNest4_Parallel
+#define DNest4_Parallel
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace DNest4
+{
+
+/*
+* Data parallelism for use inside a model, e.g. a log likelihood that is a
+* sum over a large dataset. The range [begin, end) is split into chunks of
+* 'grain' elements (by default, at most 64 chunks), which run on the
+* ThreadPool of the calling thread (see Sampler::use_thread_pool) and on
+* the calling thread itself, or one after the other if there is no pool.
+* The chunks don't depend on the number of threads, so neither do the
+* results of parallel_reduce.
+*/
+
+// Call body(chunk_begin, chunk_end) for each chunk
+void parallel_for(size_t begin, size_t end,
+					const std::function<void(size_t, size_t)>& body,
+					size_t grain=0);
+
+// Combine chunk(chunk_begin, chunk_end) over the chunks, in order,
+// starting from 'identity'
+template<class T, class Chunk, class Combine>
+T parallel_reduce(size_t begin, size_t end, const T& identity,
+					Chunk chunk, Combine combine, size_t grain=0);
+
+// Sum chunk(chunk_begin, chunk_end) over the chunks
+template<class T, class Chunk>
+T parallel_sum(size_t begin, size_t end, Chunk chunk, size_t grain=0)
+{
+	return parallel_reduce(begin, end, T(0), chunk,
+							[](const T& a, const T& b) { return a + b; }, grain);
+}
+
+// The chunk size used for a range of n elements
+size_t chunk_size(size_t n, size_t grain);
+
+template<class T, class Chunk, class Combine>
+T parallel_reduce(size_t begin, size_t end, const T& identity,
+					Chunk chunk, Combine combine, size_t grain)
+{
+	if(end <= begin)
+		return identity;
+
+	size_t size = chunk_size(end - begin, grain);
+	std::vector<T> partial((end - begin + size - 1)/size, identity);
+	parallel_for(begin, end, [&](size_t b, size_t e)
+	{
+		partial[(b - begin)/size] = chunk(b, e);
+	}, size);
+
+	T result = identity;
+	for(const T& p: partial)
+		result = combine(result, p);
+	return result;
+}
+
+} // namespace DNest4
+
+#endif
+
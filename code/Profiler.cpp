@@ -0,0 +1,62 @@
+#include "Profiler.h"
+
+namespace DNest4
+{
+
+const char* phase_name(Phase phase)
+{
+	static const char* names[] = {"mcmc", "perturb", "likelihood", "moves",
+								"level_assignment", "barrier", "level_merge",
+								"bookkeeping",
+								"level_creation", "save_levels",
+								"save_particle", "save_checkpoint"};
+	return names[static_cast<size_t>(phase)];
+}
+
+PhaseCounters::PhaseCounters()
+:steps(0)
+,accepts(0)
+{
+	for(size_t i=0; i<num_phases; ++i)
+	{
+		nanoseconds[i] = 0;
+		calls[i] = 0;
+	}
+}
+
+PhaseCounters::PhaseCounters(const PhaseCounters& other)
+:steps(other.get_steps())
+,accepts(other.get_accepts())
+{
+	for(size_t i=0; i<num_phases; ++i)
+	{
+		nanoseconds[i] = get(other.nanoseconds[i]);
+		calls[i] = get(other.calls[i]);
+	}
+}
+
+PhaseCounters& PhaseCounters::operator = (const PhaseCounters& other)
+{
+	steps = other.get_steps();
+	accepts = other.get_accepts();
+	for(size_t i=0; i<num_phases; ++i)
+	{
+		nanoseconds[i] = get(other.nanoseconds[i]);
+		calls[i] = get(other.calls[i]);
+	}
+	return *this;
+}
+
+void PhaseCounters::add(const PhaseCounters& other)
+{
+	increase(steps, other.get_steps());
+	increase(accepts, other.get_accepts());
+	for(size_t i=0; i<num_phases; ++i)
+	{
+		increase(nanoseconds[i], get(other.nanoseconds[i]));
+		increase(calls[i], get(other.calls[i]));
+	}
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,122 @@
+#ifndef DNest4_Profiler
+#define DNest4_Profiler
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace DNest4
+{
+
+/*
+* Time spent in, and calls to, each phase of the sampler, counted by each
+* thread. A thread only ever adds to its own counters, while thread zero
+* reads them all, so they are relaxed atomics: as cheap as plain integers
+* but safe to read while being written. Compiling with -DNO_PROFILING
+* removes the timers altogether.
+*/
+enum class Phase
+{
+	mcmc, perturb, likelihood, moves, level_assignment, barrier,
+	level_merge, bookkeeping, level_creation, save_levels, save_particle,
+	save_checkpoint, num_phases
+};
+
+// Name of a phase, for output
+const char* phase_name(Phase phase);
+
+class PhaseCounters
+{
+	private:
+		static const size_t num_phases = static_cast<size_t>(Phase::num_phases);
+		typedef std::atomic<unsigned long long int> Counter;
+
+		std::array<Counter, num_phases> nanoseconds;
+		std::array<Counter, num_phases> calls;
+
+		// MCMC steps, and accepted particle moves
+		Counter steps, accepts;
+
+		static void increase(Counter& counter, unsigned long long int diff)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + diff,
+							std::memory_order_relaxed);
+		}
+
+		static unsigned long long int get(const Counter& counter)
+		{ return counter.load(std::memory_order_relaxed); }
+
+	public:
+		PhaseCounters();
+		PhaseCounters(const PhaseCounters& other);
+		PhaseCounters& operator = (const PhaseCounters& other);
+
+		// Only called by the thread that owns the counters
+		void add(Phase phase, unsigned long long int ns)
+		{
+			increase(nanoseconds[static_cast<size_t>(phase)], ns);
+			increase(calls[static_cast<size_t>(phase)], 1);
+		}
+		void add_steps(unsigned long long int n) { increase(steps, n); }
+		void add_accepts(unsigned long long int n) { increase(accepts, n); }
+
+		// Getters
+		double get_seconds(Phase phase) const
+		{ return 1E-9*get(nanoseconds[static_cast<size_t>(phase)]); }
+		unsigned long long int get_calls(Phase phase) const
+		{ return get(calls[static_cast<size_t>(phase)]); }
+		unsigned long long int get_steps() const
+		{ return get(steps); }
+		unsigned long long int get_accepts() const
+		{ return get(accepts); }
+
+		// Add another thread's counts to these
+		void add(const PhaseCounters& other);
+};
+
+// Times a phase from construction to destruction, if given counters
+class PhaseTimer
+{
+	private:
+		PhaseCounters* counters;
+		Phase phase;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		PhaseTimer(PhaseCounters* counters, Phase phase)
+		:counters(counters)
+		,phase(phase)
+		{
+			if(counters != nullptr)
+				start = std::chrono::steady_clock::now();
+		}
+
+		~PhaseTimer()
+		{
+			if(counters != nullptr)
+				counters->add(phase, std::chrono::duration_cast<
+									std::chrono::nanoseconds>(
+									std::chrono::steady_clock::now() - start).count());
+		}
+
+		PhaseTimer(const PhaseTimer& other) = delete;
+		PhaseTimer& operator = (const PhaseTimer& other) = delete;
+};
+
+} // namespace DNest4
+
+// Time the rest of the enclosing scope as 'phase' on 'counters' (a
+// PhaseCounters*, or nullptr to skip)
+#ifndef NO_PROFILING
+	#define DNEST4_PROFILE_JOIN2(a, b) a##b
+	#define DNEST4_PROFILE_JOIN(a, b) DNEST4_PROFILE_JOIN2(a, b)
+	#define DNEST4_PROFILE(counters, phase) \
+		DNest4::PhaseTimer DNEST4_PROFILE_JOIN(phase_timer_, __LINE__)( \
+														(counters), (phase))
+#else
+	#define DNEST4_PROFILE(counters, phase)
+#endif
+
+#endif
+
@@ -56,3 +56,8 @@ void ClassicMassInf1D::print(std::ostream& out) const
 	out<<mu<<' ';
 }
 
+void ClassicMassInf1D::read(std::istream& in)
+{
+	in>>mu;
+}
+
@@ -2,6 +2,7 @@
 #define DNest4_ClassicMassInf1D
 
 #include "ConditionalPrior.h"
+#include <istream>
 
 namespace DNest4
 {
@@ -29,6 +30,7 @@ class ClassicMassInf1D:public ConditionalPrior
 		void to_uniform(std::vector<double>& vec) const;
 
 		void print(std::ostream& out) const;
+		void read(std::istream& in);
 };
 
 } // namespace DNest4
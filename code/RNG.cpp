@@ -6,11 +6,11 @@
 namespace DNest4
 {
 
-bool RNG::randh_is_randh2 = false;
-
 RNG::RNG()
 :uniform(0., 1.)
 ,normal(0., 1.)
+,proposal_scale(1.)
+,randh_is_randh2(false)
 {
 
 }
@@ -18,6 +18,8 @@ RNG::RNG()
 RNG::RNG(unsigned int seed)
 :uniform(0., 1.)
 ,normal(0., 1.)
+,proposal_scale(1.)
+,randh_is_randh2(false)
 {
 	set_seed(seed);
 }
@@ -47,13 +49,15 @@ double RNG::randh()
 {
 	if(randh_is_randh2)
 		return randh2();
-	return pow(10.0, 1.5 - 3*std::abs(this->randt2()))*this->randn();
+	return proposal_scale*pow(10.0, 1.5 - 3*std::abs(this->randt2()))
+				*this->randn();
 }
 
 double RNG::randh2()
 {
     Cauchy cauchy;
-	return pow(10.0, 0.5 - std::abs(cauchy.generate(*this)))*this->randn();
+	return proposal_scale*pow(10.0, 0.5 - std::abs(cauchy.generate(*this)))
+				*this->randn();
 }
 
 int RNG::rand_int(int N)
@@ -20,8 +20,12 @@ class RNG
 		// For normal distribution
 		std::normal_distribution<double> normal;
 
+		// Multiplies the output of randh() and randh2()
+		double proposal_scale;
+
     public:
-        static bool randh_is_randh2;
+        // Make randh() behave like randh2()
+        bool randh_is_randh2;
 
 	public:
         hops::RandomNumberGenerator engine;
@@ -50,6 +54,14 @@ class RNG
         // A more aggressive version of randh() [more mass near magnitude 1]
         double randh2();
 
+		// The sampler sets this before each perturb() from the level of
+		// the particle being moved. Models with their own proposals can
+		// read it to scale them.
+		void set_proposal_scale(double scale)
+		{ proposal_scale = scale; }
+		double get_proposal_scale() const
+		{ return proposal_scale; }
+
 		// Integer from {0, 1, 2, ..., N-1}
 		int rand_int(int N);
 }; // class RNG
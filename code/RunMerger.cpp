@@ -0,0 +1,377 @@
+#include "RunMerger.h"
+#include "Utils.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+namespace DNest4
+{
+
+// log(exp(a) + exp(b)), allowing either to be -infinity
+static double log_add(double a, double b)
+{
+	if(a == -numeric_limits<double>::infinity())
+		return b;
+	if(b == -numeric_limits<double>::infinity())
+		return a;
+	return logsumexp(a, b);
+}
+
+RunMerger::RunMerger(const vector<string>& directories, double cut)
+:log_Z(0.)
+,H(0.)
+,N_eff(0.)
+{
+	for(size_t r=0; r<directories.size(); ++r)
+	{
+		const string& dir = directories[r];
+		vector<Level> ladder = Level::load_levels((dir + "/levels.txt").c_str());
+		if(ladder.size() == 0)
+		{
+			cerr<<"# ERROR: No levels found in "<<dir<<"."<<endl;
+			exit(1);
+		}
+		run_levels.push_back(ladder);
+
+		// Columns are level assignment, log likelihood, tiebreaker, ID
+		vector<LikelihoodType> logl;
+		fstream fin((dir + "/sample_info.txt").c_str(), ios::in);
+		string line;
+		while(getline(fin, line))
+		{
+			if(line.size() == 0 || line[0] == '#')
+				continue;
+			stringstream s(line);
+			string assignment;
+			s>>assignment;
+			LikelihoodType l;
+			l.read(s);
+			logl.push_back(l);
+		}
+		fin.close();
+
+		vector<string> lines;
+		fin.open((dir + "/sample.txt").c_str(), ios::in);
+		while(getline(fin, line))
+		{
+			if(line.size() == 0 || line[0] == '#')
+				continue;
+			lines.push_back(line);
+		}
+		fin.close();
+
+		// A run still going may have written one file more than the other
+		size_t n = min(logl.size(), lines.size());
+		size_t start = static_cast<size_t>(cut*n);
+		for(size_t i=start; i<n; ++i)
+		{
+			sample_log_likelihoods.push_back(logl[i]);
+			sample_lines.push_back(lines[i]);
+			sample_runs.push_back(r);
+		}
+	}
+}
+
+bool RunMerger::interpolate_log_X(const vector<Level>& ladder,
+									double log_likelihood, double& log_X)
+{
+	// Level 0 carries no likelihood information
+	if(ladder.size() < 2 ||
+		log_likelihood < ladder[1].get_log_likelihood().get_value() ||
+		log_likelihood > ladder.back().get_log_likelihood().get_value())
+		return false;
+
+	// First level at or above log_likelihood
+	size_t lo = 1, hi = ladder.size() - 1;
+	while(lo < hi)
+	{
+		size_t mid = (lo + hi)/2;
+		if(ladder[mid].get_log_likelihood().get_value() < log_likelihood)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	double L1 = ladder[lo].get_log_likelihood().get_value();
+	if(lo == 1 || L1 == log_likelihood)
+	{
+		log_X = ladder[lo].get_log_X();
+		return true;
+	}
+
+	double L0 = ladder[lo-1].get_log_likelihood().get_value();
+	double f = (log_likelihood - L0)/(L1 - L0);
+	log_X = (1. - f)*ladder[lo-1].get_log_X() + f*ladder[lo].get_log_X();
+	return true;
+}
+
+double RunMerger::integrate(const vector<Level>& ladder,
+							const vector<double>& ladder_log_X,
+							const vector<LikelihoodType>& samples,
+							vector<double>& log_post)
+{
+	const double minus_inf = -numeric_limits<double>::infinity();
+
+	// Assign samples to the highest level they exceed (or equal)
+	vector<size_t> order = argsort(samples);
+	vector<size_t> assignment(samples.size());
+	vector<size_t> position(samples.size());
+	vector<size_t> count(ladder.size(), 0);
+	size_t level = 0;
+	for(size_t i: order)
+	{
+		while(level+1 < ladder.size() &&
+				!(samples[i] < ladder[level+1].get_log_likelihood()))
+			++level;
+		assignment[i] = level;
+		position[i] = count[level]++;
+	}
+
+	// Place samples uniformly in X (not log X) within their level,
+	// in order of likelihood
+	vector<double> sample_log_X(samples.size());
+	for(size_t i=0; i<samples.size(); ++i)
+	{
+		size_t j = assignment[i];
+		double log_x_max = ladder_log_X[j];
+		double log_x_min = (j+1 < ladder.size())?(ladder_log_X[j+1]):(minus_inf);
+		double n = (double)(count[j] - position[i])/(count[j] + 1);
+		sample_log_X[i] = log_add(log_x_min + log(1. - n), log_x_max + log(n));
+	}
+
+	// All points in order of X. Samples are indexed after the levels.
+	size_t num_points = ladder.size() + samples.size();
+	vector<double> log_x(num_points), log_y(num_points);
+	for(size_t i=0; i<ladder.size(); ++i)
+	{
+		log_x[i] = ladder_log_X[i];
+		log_y[i] = ladder[i].get_log_likelihood().get_value();
+	}
+	for(size_t i=0; i<samples.size(); ++i)
+	{
+		log_x[ladder.size() + i] = sample_log_X[i];
+		log_y[ladder.size() + i] = samples[i].get_value();
+	}
+	vector<size_t> indices(num_points);
+	for(size_t i=0; i<num_points; ++i)
+		indices[i] = i;
+	stable_sort(indices.begin(), indices.end(),
+			[&log_x](size_t a, size_t b) { return log_x[a] < log_x[b]; });
+
+	// Trapezoid rule, extended to X=0
+	vector<double> log_x_diff(num_points);
+	vector<double> log_p(num_points);
+	double prev_x = minus_inf;
+	double prev_y = log_y[indices[0]];
+	for(size_t k=0; k<num_points; ++k)
+	{
+		double x = log_x[indices[k]];
+		double y = log_y[indices[k]];
+		log_x_diff[k] = (x > prev_x)?((prev_x == minus_inf)?(x):(logdiffexp(x, prev_x))):(minus_inf);
+		log_p[k] = log_x_diff[k] + log(0.5) + log_add(y, prev_y);
+		prev_x = x;
+		prev_y = y;
+	}
+	double log_Z = logsumexp(log_p);
+
+	// Posterior weights of the samples
+	log_post.assign(samples.size(), minus_inf);
+	for(size_t k=0; k+1<num_points; ++k)
+	{
+		if(indices[k] < ladder.size())
+			continue;
+		size_t i = indices[k] - ladder.size();
+		log_post[i] = samples[i].get_value() + log(0.5)
+						+ log_add(log_x_diff[k+1], log_x_diff[k]);
+	}
+	double tot = minus_inf;
+	for(double lp: log_post)
+		tot = log_add(tot, lp);
+	for(double& lp: log_post)
+		lp -= tot;
+
+	return log_Z;
+}
+
+void RunMerger::merge()
+{
+	// Each run on its own ladder
+	vector<double> log_post;
+	run_log_Z.clear();
+	for(size_t r=0; r<run_levels.size(); ++r)
+	{
+		vector<LikelihoodType> samples;
+		for(size_t i=0; i<sample_runs.size(); ++i)
+			if(sample_runs[i] == r)
+				samples.push_back(sample_log_likelihoods[i]);
+
+		vector<double> ladder_log_X;
+		for(const Level& l: run_levels[r])
+			ladder_log_X.push_back(l.get_log_X());
+		run_log_Z.push_back(integrate(run_levels[r], ladder_log_X,
+										samples, log_post));
+	}
+
+	// Merged ladder: every run's thresholds, with log_X averaged over
+	// the runs whose ladders span each threshold
+	levels.assign(1, run_levels[0][0]);
+	for(const auto& ladder: run_levels)
+		for(size_t i=1; i<ladder.size(); ++i)
+			levels.push_back(ladder[i]);
+	sort(levels.begin() + 1, levels.end(),
+		[](const Level& a, const Level& b)
+		{ return a.get_log_likelihood() < b.get_log_likelihood(); });
+
+	// Each run's log_X at every threshold it spans
+	vector< vector<double> > log_X(run_levels.size(),
+									vector<double>(levels.size()));
+	vector< vector<bool> > spans(run_levels.size(),
+									vector<bool>(levels.size()));
+	vector<double> mean(levels.size(), 0.);
+	for(size_t i=1; i<levels.size(); ++i)
+	{
+		int n = 0;
+		for(size_t r=0; r<run_levels.size(); ++r)
+		{
+			spans[r][i] = interpolate_log_X(run_levels[r],
+							levels[i].get_log_likelihood().get_value(),
+							log_X[r][i]);
+			if(spans[r][i])
+			{
+				mean[i] += log_X[r][i];
+				++n;
+			}
+		}
+		mean[i] /= n;
+	}
+
+	// Average the decrements in log_X between neighbouring thresholds
+	// over the runs spanning both, which keeps the ladder monotonic as
+	// runs drop in and out. Where no run spans both, use the means.
+	levels_log_X.assign(levels.size(), 0.);
+	for(size_t i=1; i<levels.size(); ++i)
+	{
+		if(i == 1)
+		{
+			levels_log_X[i] = mean[i];
+			continue;
+		}
+
+		double tot = 0.;
+		int n = 0;
+		for(size_t r=0; r<run_levels.size(); ++r)
+		{
+			if(spans[r][i-1] && spans[r][i])
+			{
+				tot += log_X[r][i] - log_X[r][i-1];
+				++n;
+			}
+		}
+		double step = (n > 0)?(tot/n):(min(mean[i] - mean[i-1], 0.));
+		levels_log_X[i] = levels_log_X[i-1] + step;
+	}
+
+	// Pooled samples on the merged ladder
+	log_Z = integrate(levels, levels_log_X, sample_log_likelihoods,
+						log_weights);
+	H = -log_Z;
+	N_eff = 0.;
+	for(size_t i=0; i<log_weights.size(); ++i)
+	{
+		if(log_weights[i] == -numeric_limits<double>::infinity())
+			continue;
+		double w = exp(log_weights[i]);
+		H += w*sample_log_likelihoods[i].get_value();
+		N_eff -= w*log_weights[i];
+	}
+	N_eff = exp(N_eff);
+}
+
+double RunMerger::get_log_Z_std() const
+{
+	if(run_log_Z.size() < 2)
+		return 0.;
+	double mean = 0.;
+	for(double z: run_log_Z)
+		mean += z;
+	mean /= run_log_Z.size();
+	double var = 0.;
+	for(double z: run_log_Z)
+		var += pow(z - mean, 2);
+	return sqrt(var/(run_log_Z.size() - 1));
+}
+
+double RunMerger::get_log_Z_error() const
+{
+	if(run_log_Z.size() == 0)
+		return 0.;
+	return get_log_Z_std()/sqrt((double)run_log_Z.size());
+}
+
+void RunMerger::print_stats(ostream& out) const
+{
+	out<<"# Merged "<<run_levels.size()<<" runs: "<<levels.size();
+	out<<" levels, "<<sample_log_likelihoods.size()<<" samples."<<endl;
+	out<<"log(Z) = "<<log_Z<<" +- "<<get_log_Z_error();
+	out<<" (between-run std = "<<get_log_Z_std()<<")"<<endl;
+	out<<"Information = "<<H<<" nats."<<endl;
+	out<<"Effective sample size = "<<N_eff<<endl;
+}
+
+void RunMerger::save_levels(const char* filename) const
+{
+	fstream fout(filename, ios::out);
+	fout<<"# log_X, log_likelihood, tiebreaker, accepts, tries, exceeds, visits";
+	fout<<endl;
+	fout<<scientific<<setprecision(16);
+	for(size_t i=0; i<levels.size(); ++i)
+	{
+		fout<<levels_log_X[i]<<' ';
+		fout<<levels[i].get_log_likelihood().get_value()<<' ';
+		fout<<levels[i].get_log_likelihood().get_tiebreaker()<<' ';
+		fout<<levels[i].get_accepts()<<' ';
+		fout<<levels[i].get_tries()<<' ';
+		fout<<levels[i].get_exceeds()<<' ';
+		fout<<levels[i].get_visits()<<endl;
+	}
+	fout.close();
+}
+
+void RunMerger::save_weights(const char* filename) const
+{
+	fstream fout(filename, ios::out);
+	fout<<scientific<<setprecision(16);
+	for(double lw: log_weights)
+		fout<<exp(lw)<<endl;
+	fout.close();
+}
+
+void RunMerger::save_posterior_sample(const char* filename, RNG& rng,
+										double resample) const
+{
+	// Rejection sampling against the largest weight
+	double max_log_weight = -numeric_limits<double>::infinity();
+	for(double lw: log_weights)
+		max_log_weight = max(max_log_weight, lw);
+
+	int num = static_cast<int>(resample*N_eff);
+	fstream fout(filename, ios::out);
+	for(int k=0; k<num; )
+	{
+		int i = rng.rand_int(log_weights.size());
+		if(rng.rand() < exp(log_weights[i] - max_log_weight))
+		{
+			fout<<sample_lines[i]<<endl;
+			++k;
+		}
+	}
+	fout.close();
+}
+
+} // namespace DNest4
+
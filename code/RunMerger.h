@@ -0,0 +1,91 @@
+#ifndef DNest4_RunMerger
+#define DNest4_RunMerger
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Level.h"
+#include "LikelihoodType.h"
+#include "RNG.h"
+
+namespace DNest4
+{
+
+/*
+* Combines the output (levels.txt, sample_info.txt and sample.txt) of
+* several independent runs of the same model. The level ladders are
+* aligned into one, the samples of all runs are pooled and placed
+* between the merged levels, and a single log(Z) is computed along with
+* its scatter between runs.
+*/
+class RunMerger
+{
+	private:
+		// Levels of each run, with their own log_X estimates
+		std::vector< std::vector<Level> > run_levels;
+
+		// Pooled samples: likelihoods, lines of sample.txt and source run
+		std::vector<LikelihoodType> sample_log_likelihoods;
+		std::vector<std::string> sample_lines;
+		std::vector<unsigned int> sample_runs;
+
+		// The merged ladder and its log_X values
+		std::vector<Level> levels;
+		std::vector<double> levels_log_X;
+
+		// Results
+		std::vector<double> run_log_Z;
+		std::vector<double> log_weights;
+		double log_Z, H, N_eff;
+
+		// log_X of a run's ladder at the given log likelihood
+		// (false if it is outside the range spanned by that run)
+		static bool interpolate_log_X(const std::vector<Level>& ladder,
+										double log_likelihood, double& log_X);
+
+	public:
+		// Place samples uniformly in X between levels and integrate
+		// with the trapezoid rule. Returns log(Z) and fills in the
+		// normalised log posterior weights of the samples.
+		static double integrate(const std::vector<Level>& ladder,
+								const std::vector<double>& ladder_log_X,
+								const std::vector<LikelihoodType>& samples,
+								std::vector<double>& log_post);
+
+		// Load the output of each run, discarding the first
+		// 'cut' fraction of its samples as burn-in
+		RunMerger(const std::vector<std::string>& directories,
+					double cut=0.);
+
+		// Align ladders, pool samples and compute everything
+		void merge();
+
+		// Getters
+		double get_log_Z() const
+		{ return log_Z; }
+		double get_H() const
+		{ return H; }
+		double get_N_eff() const
+		{ return N_eff; }
+		const std::vector<double>& get_run_log_Z() const
+		{ return run_log_Z; }
+		const std::vector<double>& get_log_weights() const
+		{ return log_weights; }
+
+		// Standard deviation of log(Z) between runs,
+		// and the standard error of the merged estimate
+		double get_log_Z_std() const;
+		double get_log_Z_error() const;
+
+		// Outputs
+		void print_stats(std::ostream& out) const;
+		void save_levels(const char* filename) const;
+		void save_weights(const char* filename) const;
+		void save_posterior_sample(const char* filename, RNG& rng,
+									double resample=1.) const;
+};
+
+} // namespace DNest4
+
+#endif
+
@@ -1,14 +1,33 @@
 #ifndef DNest4_Sampler
 #define DNest4_Sampler
 
+#include <array>
 #include <vector>
 #include <thread>
+#include <chrono>
+#include <functional>
+#include <utility>
+#include <memory>
 #include <ostream>
 #include <istream>
+#include <string>
 #include "LikelihoodType.h"
 #include "Options.h"
+#include "Profiler.h"
+#include "Trace.h"
 #include "Level.h"
+#include "Logger.h"
+#include "MetricsServer.h"
 #include "Barrier.h"
+#include "ControlFile.h"
+#include "Coordinator.h"
+#include "DelayedAcceptance.h"
+#include "EnsembleMove.h"
+#include "GalileanMove.h"
+#include "SliceMove.h"
+#include "SignalHandling.h"
+#include "StoppingRules.h"
+#include "ThreadPool.h"
 
 namespace DNest4
 {
@@ -59,6 +78,15 @@ private:
 		// Random number generators
 		std::vector<RNG> rngs;
 
+		// Connection to a coordinator sharing levels between processes
+		std::shared_ptr<CoordinatorClient> coordinator;
+
+		// Commands from outside, checked during bookkeeping
+		std::shared_ptr<ControlFile> control;
+
+		// Number of lagging particles replaced so far
+		unsigned int num_deletions;
+
 		// Number of saved particles
 		unsigned int count_saves;
         unsigned int count_mcmc_steps_since_save;
@@ -67,24 +95,219 @@ private:
         // For adaptation
         double difficulty, work_ratio;
 
+        // Number of levels adopted from a previous run (warm start),
+        // and those which look inconsistent with the new target
+        unsigned int num_adopted_levels;
+        std::vector<unsigned int> inconsistent_levels;
+
+        // Rules for ending the run early
+        StoppingRules stopping_rules;
+
+        // When the run started (construction, until run() is called)
+        std::chrono::steady_clock::time_point start_time
+                                        = std::chrono::steady_clock::now();
+
+        // MCMC steps done before run() was called, for rates
+        unsigned long long int start_steps = 0;
+
+        // Where metrics are published (a file and/or a local endpoint),
+        // at most every metrics_interval seconds
+        std::string metrics_file;
+        std::shared_ptr<MetricsServer> metrics_server;
+        double metrics_interval = 1.;
+        std::chrono::steady_clock::time_point last_metrics;
+        unsigned long long int last_metrics_steps = 0;
+
+        // Where messages go. Shared so that copies of the sampler keep
+        // writing through the same background thread.
+        std::shared_ptr<Logger> logger = std::make_shared<Logger>();
+
+        // When the last checkpoint was written (zero if never)
+        std::chrono::system_clock::time_point last_checkpoint_time;
+
+        // Likelihood evaluations done by each thread
+        std::vector<unsigned long long int> count_likelihood_evaluations;
+
+        // Whether perturb() proposals are screened with the model's
+        // surrogate likelihood, and each thread's count of proposals
+        // screened, of those passed on to the exact likelihood, and of
+        // those then accepted
+        bool delayed_acceptance = false;
+        std::vector< std::array<unsigned long long int, 3> > screening_counts;
+
+        // Likelihoods of the saved particles (kept only if a stopping
+        // rule needs estimates), and the estimates of log(Z) made since
+        // all levels were created. Each estimate integrates over every
+        // saved particle, so one is only made once the saves have grown
+        // by 1% since the last. After resuming from a checkpoint the
+        // earlier saves are read back when first needed.
+        std::vector<LikelihoodType> saved_log_likelihoods;
+        bool saved_log_likelihoods_loaded = true;
+        std::vector<double> log_Z_history;
+        size_t last_estimate_saves = 0;
+
+        // Optimiser mode: no posterior output, levels are created for as
+        // long as the run lasts, and each thread keeps its best top_k
+        // particles (as a heap with the worst of them at the front)
+        bool optimiser_mode = false;
+        unsigned int top_k = 0;
+        std::vector< std::vector< std::pair<LikelihoodType, ModelType> > >
+                                                            top_particles;
+        std::function<void(ModelType&, RNG&)> refine;
+
+        // Automatic choice of thread_steps: the target fraction of each
+        // round spent outside MCMC (zero for off) and the allowed range
+        double target_overhead = 0.;
+        unsigned int min_thread_steps = 1;
+        unsigned int max_thread_steps = 1;
+
+        // Time (in seconds) spent on each part of the rounds since
+        // thread_steps was last tuned
+        std::vector<double> mcmc_time;
+        std::vector<double> barrier_time;
+        double bookkeeping_time = 0.;
+        double round_time = 0.;
+        unsigned int count_rounds_timed = 0;
+
+        // MCMC steps done by each thread in the current round
+        std::vector<unsigned int> round_steps;
+
+        // Galilean moves: how often they replace perturb(), their length,
+        // the target fraction of straight steps, and each thread's log
+        // step size for each level
+        double galilean_probability = 0.;
+        unsigned int galilean_steps = 20;
+        double galilean_target = 0.5;
+        std::vector< std::vector<double> > galilean_log_step;
+
+        // Slice moves: how often they replace perturb(), and each
+        // thread's log interval width for each level
+        double slice_probability = 0.;
+        std::vector< std::vector<double> > slice_log_width;
+
+        // How often ensemble moves replace perturb()
+        double ensemble_probability = 0.;
+
+        // Timings of the phases of each thread (see Profiler.h), if
+        // profiling, and the file they are summarised in every
+        // profile_interval seconds
+        bool profiling = false;
+        mutable std::vector<PhaseCounters> phase_counters;
+        std::string profile_file;
+        double profile_interval = 10.;
+        std::chrono::steady_clock::time_point last_profile_write;
+
+        // Timeline of each thread (see Trace.h), if tracing, and the
+        // file it is written to at the end of the run
+        bool tracing = false;
+        mutable std::vector<TraceBuffer> trace_buffers;
+        std::string trace_file;
+        size_t trace_capacity = 65536;
+
+        // Whether a single thread may update the levels (and all_above)
+        // directly instead of copies that are merged after each round,
+        // and whether the current run does
+        bool allow_levels_in_place = true;
+        bool levels_in_place = false;
+
+        // Number of perturb() proposals made at once by multiple-try moves
+        unsigned int num_tries = 1;
+
+        // Workers for multiple-try moves and the model's parallel work
+        // (see Parallel.h), helped by sampler threads waiting at barriers
+        std::shared_ptr<ThreadPool> pool;
+
+        // Acceptance rate targeted by the per-level scale of perturb()
+        // (zero for no scaling), the log scale of each level, and the
+        // accepts and tries of each level when they were last adapted
+        double proposal_target = 0.;
+        std::vector<double> log_proposal_scales;
+        std::vector<unsigned long long int> proposal_accepts;
+        std::vector<unsigned long long int> proposal_tries;
+
 		// Storage for likelihoods above threshold
 public:
 		std::vector< std::vector<LikelihoodType> > above;
 private:
 
 		/* Private methods */
+		// Draw the particles belonging to thread 'thread' from the prior,
+		// seeding particle i with first_particle_seed + i
+		void initialise_thread(unsigned int thread,
+								unsigned int first_particle_seed);
+
 		// Master function to be called from each thread
 		void run_thread(unsigned int thread);
 
+		// Where thread 'thread' counts its phases (nullptr if not profiling)
+		PhaseCounters* profile_counters(unsigned int thread) const
+		{ return (profiling)?(&phase_counters[thread]):(nullptr); }
+
+		// Where thread 'thread' records its timeline (nullptr if not
+		// tracing)
+		TraceBuffer* trace_buffer(unsigned int thread) const
+		{ return (tracing)?(&trace_buffers[thread]):(nullptr); }
+
+		// The current metrics, in the Prometheus text format
+		std::string metrics_text() const;
+
+		// Write the metrics to metrics_file and/or the endpoint
+		void publish_metrics();
+
+		// Write the profile summary to profile_file
+		void save_profile();
+
+		// The levels updated by thread 'thread' during a round
+		std::vector<Level>& thread_levels(unsigned int thread)
+		{ return (levels_in_place)?(levels):(copies_of_levels[thread]); }
+
 		// Do an MCMC step of particle 'which' on thread 'thread'
 		void update_particle(unsigned int thread, unsigned int which);
 
+		// A per-level scale of a thread's moves, growing 'scales' as
+		// levels are added (new levels start from the one below)
+		double& level_scale(std::vector<double>& scales, unsigned int level,
+							double initial);
+
+		// Move particle 'which' using two other particles of its thread
+		// at the same or a higher level. Returns false if there aren't
+		// two such particles.
+		bool ensemble_move(unsigned int thread, unsigned int which,
+							bool& moved);
+
+		// Report what delayed acceptance has saved
+		void print_screening_rates() const;
+
+		// Adapt the proposal scale of each level towards proposal_target,
+		// while levels are being created
+		void adapt_proposal_scales();
+
+		// A multiple-try Metropolis move of particle 'which'. Returns
+		// whether the particle moved.
+		bool multiple_try_move(unsigned int thread, unsigned int which);
+
+		// Replace each of 'tries' with the result of a perturb() move
+		// from it, in parallel, counting the likelihood evaluations.
+		// Sets 'valid' to whether each result is above 'threshold'.
+		void propose_tries(unsigned int thread, std::vector<ModelType>& tries,
+							std::vector<LikelihoodType>& logls,
+							std::vector<bool>& valid, std::vector<bool>& moved,
+							const LikelihoodType& threshold, double scale);
+
+		// Count the visits and exceeds of particle 'which' after a move
+		void count_visits_and_exceeds(unsigned int thread, unsigned int which);
+
 		// Do an MCMC step of the level assignment of particle 'which' on thread
 		// 'thread'
 		void update_level_assignment(unsigned int thread, unsigned int which);
 
-		// Do MCMC for a while on thread 'thread'
-		void mcmc_thread(unsigned int thread);
+		// Do MCMC for a while on thread 'thread'. Returns the number
+		// of steps done, which is fewer than thread_steps when draining.
+		unsigned int mcmc_thread(unsigned int thread);
+
+		// Send this round's level counts and likelihoods above the top
+		// level to the coordinator, and adopt the levels it returns
+		void exchange_levels(const std::vector<Level>& levels_orig);
 
 		// Add new levels, save output files, etc
 		void do_bookkeeping();
@@ -98,29 +321,78 @@ private:
         // Are there enough levels?
         bool enough_levels(const std::vector<Level>& l) const;
 
+        // Check compressions of adopted levels against the target
+        void check_adopted_levels();
+
+        // Offer particle 'which' to the top particles of thread 'thread'
+        void offer_top_particle(unsigned int thread, unsigned int which);
+
+        // Refine the top particles and save the best one
+        void finish_optimisation();
+
+        // Adjust thread_steps using the timings of recent rounds
+        void tune_thread_steps();
+
+        // Apply any commands waiting in the control file
+        void apply_control();
+
+        // Has any stopping rule been met? 'saved' says whether
+        // a particle was saved during this bookkeeping step.
+        bool check_stopping_rules(bool saved);
+
+        // Read back the likelihoods of the particles saved so far
+        void load_saved_log_likelihoods();
+
+		// Redistribute the particles and RNGs of a checkpoint written
+		// with 'saved_num_threads' threads onto this sampler's threads
+		void reshard(unsigned int saved_num_threads);
+
 		void initialise_output_files() const;
 		void save_levels() const;
         void save_best_particle() const;
 		void save_particle();
 
 	public:
-		Sampler () {};
+		// Takes its layout from whatever read() loads
+		Sampler () : num_threads(0) {};
 
 		// Constructor: Pass in Options object
 		Sampler(unsigned int num_threads,
 						double compression, const Options& options);
 
-		// Constructor: Pass in Options object and save_to_disk
+		// Constructor: Pass in Options object and save_to_disk.
+		// Particles start as copies of 'prototype', which is how
+		// a model can be given its own dataset.
 		Sampler(unsigned int num_threads,
 						double compression, const Options& options,
-						bool save_to_disk, bool _adaptive);
+						bool save_to_disk, bool _adaptive,
+						const ModelType& prototype=ModelType());
 
 		// Set rng seeds, then draw all particles from the prior
 		void initialise(unsigned int first_seed, bool continue_from_checkpoint=false);
 
-		// Launch everything
+		// Adopt the likelihood thresholds of a previous run, from its
+		// levels file or checkpoint. Keep every 'thin'th level and/or
+		// re-space them to this sampler's compression.
+		void warm_start(const std::string& filename, unsigned int thin=1,
+						bool respace=false);
+
+		// Share levels with other processes through a coordinator
+		// at "host:port"
+		void connect_to_coordinator(const std::string& address);
+
+		// Take commands from 'filename' while running: "save_interval n",
+		// "max_num_saves n", "thread_steps n", "new_level_interval n",
+		// "thin n", "beta x", "checkpoint", "flush" and "stop"
+		void set_control_file(const std::string& filename);
+
+		// Launch everything, reporting every 'thin'th save
 		void run(unsigned int thin=1);
 
+		// Run a single-threaded sampler on the calling thread, e.g.
+		// when it is one job among many on a ThreadPool
+		void run_on_this_thread(unsigned int thin=1);
+
 		// Increase max_num_saves (allows continuation)
 		void increase_max_num_saves(unsigned int increment);
 
@@ -128,6 +400,129 @@ private:
         void set_max_num_saves(unsigned int n)
         { options.max_num_saves = n; }
 
+        // Stop the run early when any of these rules is met
+        void set_stopping_rules(const StoppingRules& rules)
+        { stopping_rules = rules; }
+
+        // Use the sampler as an optimiser, keeping the best top_k particles
+        // of each thread. Must be called before initialise().
+        void set_optimiser_mode(unsigned int top_k=10);
+
+        // A local optimiser applied to the top particles at the end of an
+        // optimisation. It must leave the particle's log_likelihood() valid.
+        void set_refinement(const std::function<void(ModelType&, RNG&)>& func)
+        { refine = func; }
+
+        // Choose thread_steps automatically so that barriers and
+        // bookkeeping take about 'target_overhead' (a fraction) of the time
+        void set_thread_steps_tuning(double target_overhead,
+                                     unsigned int min_steps=1,
+                                     unsigned int max_steps=100000);
+
+        // Replace a fraction 'probability' of the perturb() moves with
+        // Galilean trajectories of num_steps steps. The model must provide
+        // coordinates and a gradient (see ModelTraits.h).
+        void set_galilean_moves(double probability, unsigned int num_steps=20,
+                                double target=0.5);
+
+        // Replace a fraction 'probability' of the perturb() moves with
+        // slice sampling. The model must provide coordinates (see
+        // ModelTraits.h).
+        void set_slice_moves(double probability);
+
+        // Replace a fraction 'probability' of the perturb() moves with
+        // ensemble moves. The model must provide coordinates (see
+        // ModelTraits.h).
+        void set_ensemble_moves(double probability);
+
+        // Make num_tries perturb() proposals at once and choose among
+        // those above the level (multiple-try Metropolis), evaluating
+        // them on a pool of num_workers threads (by default, the cores
+        // not used by the sampler's own threads)
+        void set_multiple_tries(unsigned int num_tries,
+                                unsigned int num_workers=0);
+
+        // With one thread, update the levels directly rather than through
+        // a copy merged after each round (the default). The output is the
+        // same either way.
+        void set_levels_in_place(bool value)
+        { allow_levels_in_place = value; }
+
+        // Give the sampler a pool of num_workers threads (by default, the
+        // cores not used by the sampler's own threads, or the existing
+        // pool) for multiple-try moves and for the model's parallel_for()
+        // and parallel_reduce() calls (see Parallel.h)
+        void use_thread_pool(unsigned int num_workers=0);
+
+        // Share a pool, e.g. between samplers
+        void set_thread_pool(const std::shared_ptr<ThreadPool>& pool)
+        { this->pool = pool; }
+
+        const std::shared_ptr<ThreadPool>& get_thread_pool() const
+        { return pool; }
+
+        // Publish metrics for monitoring (steps per second, levels,
+        // difficulty, acceptance per level, saves, last checkpoint and
+        // time remaining) at most every 'interval' seconds, to 'filename'
+        // (replaced atomically) and/or over HTTP at 'address', a loopback
+        // port or a Unix socket path (see MetricsServer). Either may be
+        // empty.
+        void set_metrics(const std::string& filename,
+                         const std::string& address="", double interval=1.);
+
+        // Time the phases of each thread (see Profiler.h), and if
+        // 'filename' is given, write a summary to it every 'interval'
+        // seconds and at the end of the run
+        void set_profiling(bool value, const std::string& filename="",
+                           double interval=10.);
+
+        // Each thread's phase timings and counts
+        const std::vector<PhaseCounters>& get_phase_counters() const
+        { return phase_counters; }
+
+        // Time per phase, then steps and likelihood evaluations per
+        // second, acceptance and time idle at barriers per thread
+        void print_profile(std::ostream& out) const;
+
+        // Record a timeline of each thread, keeping its last 'capacity'
+        // events, and write it to 'filename' (if given) at the end of the
+        // run. A "trace [filename]" command in the control file writes
+        // it while running.
+        void set_tracing(bool value, const std::string& filename="",
+                         size_t capacity=65536);
+
+        // Write the timeline in the Chrome trace format (open it in
+        // chrome://tracing or Perfetto). Call it between rounds or after
+        // the run, when the threads aren't recording.
+        void save_trace(const std::string& filename) const;
+
+        // The sampler's messages: change the level, sinks or rate limit
+        // here (see Logger.h)
+        Logger& get_logger() const
+        { return *logger; }
+
+        // Each thread's timeline
+        const std::vector<TraceBuffer>& get_trace_buffers() const
+        { return trace_buffers; }
+
+        // Screen perturb() proposals with the model's surrogate likelihood
+        // before computing the exact one (delayed acceptance). The model
+        // must provide a surrogate (see ModelTraits.h).
+        void set_delayed_acceptance(bool value);
+
+        // Scale the perturb() proposals of each level, through
+        // RNG::get_proposal_scale(), so that they are accepted at about the
+        // rate 'target'. The scales adapt while levels are being created
+        // and are fixed afterwards.
+        void set_proposal_scaling(double target);
+
+        // Use randh2() in place of randh() on all RNGs
+        void set_randh_is_randh2(bool value)
+        {
+            for(auto& rng: rngs)
+                rng.randh_is_randh2 = value;
+        }
+
 		// GETTERS!!!
 		const std::vector<ModelType>& get_particles() const
 		{ return particles; }
@@ -143,9 +538,41 @@ private:
 
 		const std::vector<Level>& get_levels () const { return levels; };
 
+		// Adopted levels whose compression disagrees with the target
+		const std::vector<unsigned int>& get_inconsistent_levels() const
+		{ return inconsistent_levels; }
+
+        // The best particle found so far (the optimum, in optimiser mode)
+        const ModelType& get_best_particle() const
+        { return best_ever_particle; }
+
+        const LikelihoodType& get_best_log_likelihood() const
+        { return best_ever_log_likelihood; }
+
+        // The top particles of all threads, best first
+        std::vector< std::pair<LikelihoodType, ModelType> >
+                                        get_top_particles() const;
+
         std::vector<DNest4::RNG> get_rngs() const
         { return rngs; }
 
+        unsigned long long int get_count_mcmc_steps() const
+        { return count_mcmc_steps; }
+
+        // Likelihood evaluations done by this process
+        unsigned long long int get_count_likelihood_evaluations() const;
+
+        // Proposals screened with the surrogate likelihood, passed on to
+        // the exact likelihood, and then accepted, by this process
+        void get_screening_counts(unsigned long long int& screened,
+                                  unsigned long long int& passed,
+                                  unsigned long long int& accepted) const;
+
+        // Estimate log(Z) and the effective sample size from the
+        // particles saved so far (by this process or the run it resumed).
+        // Only the saves kept for the stopping rules are used.
+        void estimate_log_Z(double& log_Z, double& ess) const;
+
 		void print(std::ostream& out) const;
 		void read(std::istream& in);
 
@@ -7,7 +7,10 @@
 #include <thread>
 #include <algorithm>
 #include <iomanip>
+#include <limits>
+#include <sstream>
 
+#include "RunMerger.h"
 #include "Utils.h"
 #include "Pybind11_abortable.hpp"
 
@@ -17,7 +20,7 @@ namespace DNest4
 template<class ModelType>
 Sampler<ModelType>::Sampler(unsigned int num_threads, double compression,
 							const Options& options, bool save_to_disk,
-                            bool _adaptive)
+                            bool _adaptive, const ModelType& prototype)
 :save_to_disk(save_to_disk)
 ,thin_print(1)
 ,threads(num_threads, nullptr)
@@ -26,27 +29,35 @@ Sampler<ModelType>::Sampler(unsigned int num_threads, double compression,
 ,compression(compression)
 ,options(options)
 ,adaptive(_adaptive)
-,particles(options.num_particles*num_threads)
+,particles(options.num_particles*num_threads, prototype)
 ,log_likelihoods(options.num_particles*num_threads)
 ,level_assignments(options.num_particles*num_threads, 0)
 ,levels(1, LikelihoodType())
 ,copies_of_levels(num_threads, levels)
 ,all_above()
 ,rngs(num_threads)
+,num_deletions(0)
 ,count_saves(0)
 ,count_mcmc_steps_since_save(0)
 ,count_mcmc_steps(0)
 ,difficulty(1.0)
 ,work_ratio(1.0)
+,num_adopted_levels(0)
+,count_likelihood_evaluations(num_threads, 0)
+,top_particles(num_threads)
+,mcmc_time(num_threads, 0.)
+,barrier_time(num_threads, 0.)
+,round_steps(num_threads, 0)
 ,above(num_threads)
 {
 	assert(num_threads >= 1);
 	assert(compression > 1.);
 
-    std::cout << "using threads " << num_threads << std::endl;
+    logger->debug() << "# Sampler with " << num_threads << " threads.";
 
     if(options.max_num_levels == 0 && std::abs(compression - exp(1.0)) > 1E-6)
     {
+        logger->flush();
         std::cerr<<"# ERROR: Cannot use -c with max_num_levels=0 (AUTO).";
         std::cerr<<std::endl;
         exit(0);
@@ -56,20 +67,22 @@ Sampler<ModelType>::Sampler(unsigned int num_threads, double compression,
     auto indices = argsort(log_likelihoods);
     best_ever_particle = particles[indices.back()];
     best_ever_log_likelihood = log_likelihoods[indices.back()];
-    std::cout << std::scientific << std::setprecision(16);
 }
 
 template<class ModelType>
 void Sampler<ModelType>::save_checkpoint() {
+    DNEST4_PROFILE(profile_counters(0), Phase::save_checkpoint);
+    DNEST4_TRACE(trace_buffer(0), "save_checkpoint");
     std::string temp_name = options.checkpoint_file + ".next";
     std::fstream fout(temp_name, std::ios::out);
     if(fout.is_open()) {
         this->print(fout);
         fout.close();
         std::rename(temp_name.c_str(), options.checkpoint_file.c_str());
+        last_checkpoint_time = std::chrono::system_clock::now();
     }
     else {
-        std::cerr << "error saving checkpoint. Continuing" << std::endl;
+        logger->error() << "error saving checkpoint. Continuing";
     }
 }
 
@@ -80,15 +93,46 @@ void Sampler<ModelType>::read_checkpoint() {
         this->read(fin);
     }
     else {
+        logger->flush();
         std::cerr << "error loading checkpoint. Aborting" << std::endl;
         exit(1);
     }
+
+    // The likelihoods of the particles saved so far are only read back
+    // if a stopping rule needs them (see load_saved_log_likelihoods())
+    saved_log_likelihoods.clear();
+    saved_log_likelihoods_loaded = false;
+    log_Z_history.clear();
+    last_estimate_saves = 0;
     if(options.max_num_saves != 0 && count_saves>=options.max_num_saves) {
-        std::cout << "max num saves already achieved. Increase the max_num_saves to continue sampling." << std::endl;
+        logger->warning() << "max num saves already achieved. Increase the max_num_saves to continue sampling.";
     }
 }
 
 
+template<class ModelType>
+void Sampler<ModelType>::load_saved_log_likelihoods()
+{
+    saved_log_likelihoods_loaded = true;
+    if(!save_to_disk)
+        return;
+
+    // Everything saved so far, by this process and the run it resumed
+    saved_log_likelihoods.clear();
+    std::fstream info(options.sample_info_file, std::ios::in);
+    std::string line;
+    while(saved_log_likelihoods.size() < count_saves && std::getline(info, line)) {
+        if(line.size() == 0 || line[0] == '#')
+            continue;
+        std::stringstream s(line);
+        unsigned int assignment;
+        s >> assignment;
+        LikelihoodType l;
+        l.read(s);
+        saved_log_likelihoods.push_back(l);
+    }
+}
+
 template<class ModelType>
 void Sampler<ModelType>::initialise(unsigned int first_seed, bool continue_from_checkpoint)
 {
@@ -101,30 +145,178 @@ void Sampler<ModelType>::initialise(unsigned int first_seed, bool continue_from_
 
     if(continue_from_checkpoint) {
         read_checkpoint();
-        std::cout << "# Continuing from checkpoint. ";
-        std::cout<< "Loaded " << count_saves << " saves and " << count_mcmc_steps << " mcmc steps." << std::endl;
+        logger->info() << "# Continuing from checkpoint. "
+            << "Loaded " << count_saves << " saves and " << count_mcmc_steps << " mcmc steps.";
     }
     else {
-        std::cout << "# Seeding random number generators. First seed = ";
-        std::cout << first_seed << "." << std::endl;
+        logger->info() << "# Seeding random number generators. First seed = "
+            << first_seed << ".";
+        // Each first seed has its own block of RNG and particle seeds,
+        // so that runs with different seeds (e.g. workers sharing a
+        // coordinator) don't share streams or draw the same particles
+        const unsigned int first_particle_seed = first_seed*particles.size();
+        unsigned int seed = first_seed*num_threads;
+
         // Seed the RNGs, incrementing the seed each time
         for (RNG &rng: rngs) {
-            rng.set_seed(first_seed++);
+            rng.set_seed(seed++);
         }
 
-        std::cout << "# Generating " << particles.size();
-        std::cout << " particle" << ((particles.size() > 1) ? ("s") : (""));
-        std::cout << " from the prior..." << std::flush;
-        // Reference to an RNG to use
-        RNG& rng = rngs[0];
-        for (size_t i = 0; i < particles.size(); ++i) {
-            particles[i].from_prior(i);
-            log_likelihoods[i] = LikelihoodType(particles[i].log_likelihood(),
-                                                rng.rand());
+        logger->info() << "# Generating " << particles.size()
+            << " particle" << ((particles.size() > 1) ? ("s") : (""))
+            << " from the prior...";
+        auto start_time = std::chrono::steady_clock::now();
+
+#ifndef NO_THREADS
+        // Each thread draws its own shard of particles. With only one
+        // (e.g. a Batch job on a pool worker) it's done on this thread.
+        if(num_threads == 1) {
+            initialise_thread(0, first_particle_seed);
         }
-        std::cout << "done." << std::endl;
+        else {
+            std::vector<std::thread> init_threads;
+            for(unsigned int i=0; i<num_threads; ++i) {
+                auto func = std::bind(&Sampler<ModelType>::initialise_thread,
+                                      this, i, first_particle_seed);
+                init_threads.push_back(std::thread(func));
+            }
+            for(auto& t: init_threads) {
+                t.join();
+            }
+        }
+#else
+        for(unsigned int i=0; i<num_threads; ++i)
+            initialise_thread(i, first_particle_seed);
+#endif
+
+        std::chrono::duration<double> elapsed =
+                            std::chrono::steady_clock::now() - start_time;
+        logger->info() << "# ...done (" << std::fixed << std::setprecision(3)
+            << elapsed.count() << " s).";
         initialise_output_files();
     }
+    logger->flush();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::warm_start(const std::string& filename,
+                                    unsigned int thin, bool respace)
+{
+    assert(thin >= 1);
+
+    // A levels file starts with a comment line, a checkpoint doesn't
+    std::vector<Level> old_levels;
+    std::vector<double> old_scales;
+    std::fstream fin(filename, std::ios::in);
+    if(!fin.is_open()) {
+        logger->flush();
+        std::cerr << "error loading levels for warm start. Aborting" << std::endl;
+        exit(1);
+    }
+    if(fin.peek() == '#') {
+        fin.close();
+        old_levels = Level::load_levels(filename.c_str());
+    }
+    else {
+        // read() builds the old particles from this one, so that they
+        // get whatever the prototype gave them (e.g. a dataset)
+        Sampler<ModelType> old_sampler;
+        if(particles.size() > 0)
+            old_sampler.particles.assign(1, particles[0]);
+        old_sampler.read(fin);
+        old_levels = old_sampler.levels;
+        old_scales = old_sampler.log_proposal_scales;
+    }
+    if(old_levels.size() == 0) {
+        logger->flush();
+        std::cerr << "error: no levels found in " << filename << ". Aborting" << std::endl;
+        exit(1);
+    }
+
+    // Indices of the old levels to keep
+    std::vector<size_t> keep(1, 0);
+    if(respace) {
+        // Closest old level to each multiple of the target compression
+        double step = log(compression);
+        double bottom = old_levels.back().get_log_X() - 0.5*step;
+        for(int k=1; -k*step >= bottom; ++k) {
+            size_t best = 0;
+            for(size_t i=1; i<old_levels.size(); ++i) {
+                if(std::abs(old_levels[i].get_log_X() + k*step) <
+                   std::abs(old_levels[best].get_log_X() + k*step))
+                    best = i;
+            }
+            if(best > keep.back())
+                keep.push_back(best);
+        }
+    }
+    else {
+        for(size_t i=1; i<old_levels.size(); ++i)
+            keep.push_back(i);
+    }
+
+    // Proposal scales only carry over into a run that adapts them
+    if(proposal_target <= 0.)
+        old_scales.clear();
+
+    // Adopt the thresholds, and proposal scales from a checkpoint.
+    // Counts start afresh.
+    levels = std::vector<Level>(1, Level(LikelihoodType()));
+    log_proposal_scales.assign(old_scales.begin(),
+                        old_scales.begin() + std::min<size_t>(1, old_scales.size()));
+    for(size_t i=thin; i<keep.size(); i += thin) {
+        if(options.max_num_levels != 0 && levels.size() >= options.max_num_levels)
+            break;
+        levels.push_back(Level(old_levels[keep[i]].get_log_likelihood()));
+        if(keep[i] < old_scales.size() &&
+           log_proposal_scales.size() + 1 == levels.size())
+            log_proposal_scales.push_back(old_scales[keep[i]]);
+    }
+    proposal_accepts.clear();
+    proposal_tries.clear();
+    Level::recalculate_log_X(levels, compression,
+                        options.new_level_interval*sqrt(options.lambda));
+    copies_of_levels = std::vector< std::vector<Level> >(num_threads, levels);
+
+    all_above.clear();
+    for(auto& a: above) {
+        a.clear();
+    }
+    for(auto& l: level_assignments) {
+        l = 0;
+    }
+
+    num_adopted_levels = levels.size();
+    inconsistent_levels.clear();
+
+    logger->info() << "# Warm start: adopted " << levels.size() - 1 << " of "
+        << old_levels.size() - 1 << " levels from " << filename << ".";
+    if(enough_levels(levels)) {
+        logger->info() << "# Done creating levels.";
+    }
+    save_levels();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::initialise_thread(unsigned int thread,
+                                           unsigned int first_particle_seed)
+{
+	// Reference to the RNG for this thread
+	RNG& rng = rngs[thread];
+
+	// The model's parallel work goes to the sampler's pool
+	ThreadPool::Using using_pool(pool.get());
+
+	// This thread's shard of particles
+	const size_t start_index = thread*options.num_particles;
+	const size_t end_index = start_index + options.num_particles;
+	for(size_t i=start_index; i<end_index; ++i)
+	{
+		particles[i].from_prior(first_particle_seed + i);
+		log_likelihoods[i] = LikelihoodType(particles[i].log_likelihood(),
+											rng.rand());
+		++count_likelihood_evaluations[thread];
+	}
 }
 
 template<class ModelType>
@@ -146,6 +338,8 @@ void Sampler<ModelType>::run(unsigned int thin)
 
 	isThreadDone = std::vector<bool>(threads.size(), false);
     this->shouldThreadsStop = false;
+    start_time = std::chrono::steady_clock::now();
+    start_steps = count_mcmc_steps;
 
     // Create the barrier
 	barrier = new Barrier(num_threads);
@@ -180,27 +374,171 @@ void Sampler<ModelType>::run(unsigned int thin)
 		t = nullptr;
 	}
 #else
+	start_time = std::chrono::steady_clock::now();
+	start_steps = count_mcmc_steps;
 	// TODO check signal is caught here too
 	for(size_t i=0; i<threads.size(); ++i) run_thread(i);
 #endif
+
+	// The drain has been served; later runs shouldn't drain at once
+	if(drain_requested())
+		reset_drain();
+
+	if(optimiser_mode)
+		finish_optimisation();
+	if(profiling && profile_file != "")
+		save_profile();
+	if(tracing && trace_file != "")
+		save_trace(trace_file);
+	if(metrics_file != "" || metrics_server)
+		publish_metrics();
+	logger->flush();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::run_on_this_thread(unsigned int thin)
+{
+	assert(num_threads == 1);
+	thin_print = thin;
+
+	isThreadDone = std::vector<bool>(1, false);
+	shouldThreadsStop = false;
+	start_time = std::chrono::steady_clock::now();
+	start_steps = count_mcmc_steps;
+
+#ifndef NO_THREADS
+	// A barrier of one never blocks
+	if(barrier != nullptr)
+		delete barrier;
+	barrier = new Barrier(1);
+#endif
+
+	run_thread(0);
+
+#ifndef NO_THREADS
+	delete barrier;
+	barrier = nullptr;
+#endif
+
+	if(optimiser_mode)
+		finish_optimisation();
+	if(profiling && profile_file != "")
+		save_profile();
+	if(tracing && trace_file != "")
+		save_trace(trace_file);
+	if(metrics_file != "" || metrics_server)
+		publish_metrics();
+	logger->flush();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_optimiser_mode(unsigned int top_k)
+{
+    assert(top_k >= 1);
+    optimiser_mode = true;
+    this->top_k = top_k;
+    top_particles.assign(num_threads,
+                    std::vector< std::pair<LikelihoodType, ModelType> >());
+    for(auto& top: top_particles) {
+        top.reserve(top_k);
+    }
+
+    // No cap on the number of levels
+    options.max_num_levels = std::numeric_limits<unsigned int>::max();
 }
 
 template<class ModelType>
-void Sampler<ModelType>::mcmc_thread(unsigned int thread)
+void Sampler<ModelType>::offer_top_particle(unsigned int thread,
+                                            unsigned int which)
+{
+    // Min-heap on log likelihood: the front is the one to beat
+    auto worse = [](const std::pair<LikelihoodType, ModelType>& a,
+                    const std::pair<LikelihoodType, ModelType>& b)
+                    { return b.first < a.first; };
+
+    auto& top = top_particles[thread];
+    if(top.size() < top_k) {
+        top.push_back(std::make_pair(log_likelihoods[which], particles[which]));
+        std::push_heap(top.begin(), top.end(), worse);
+    }
+    else if(top.front().first < log_likelihoods[which]) {
+        std::pop_heap(top.begin(), top.end(), worse);
+        top.back().first = log_likelihoods[which];
+        top.back().second = particles[which];
+        std::push_heap(top.begin(), top.end(), worse);
+    }
+}
+
+template<class ModelType>
+std::vector< std::pair<LikelihoodType, ModelType> >
+                            Sampler<ModelType>::get_top_particles() const
+{
+    std::vector< std::pair<LikelihoodType, ModelType> > all;
+    for(const auto& top: top_particles) {
+        all.insert(all.end(), top.begin(), top.end());
+    }
+    std::sort(all.begin(), all.end(),
+            [](const std::pair<LikelihoodType, ModelType>& a,
+               const std::pair<LikelihoodType, ModelType>& b)
+            { return b.first < a.first; });
+    return all;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::finish_optimisation()
+{
+    std::vector< std::pair<LikelihoodType, ModelType> > top = get_top_particles();
+
+    if(refine) {
+        logger->info() << "# Refining the best " << top.size() << " particles...";
+        for(auto& t: top) {
+            refine(t.second, rngs[0]);
+            t.first = LikelihoodType(t.second.log_likelihood(),
+                                     t.first.get_tiebreaker());
+        }
+        logger->info() << "# ...done.";
+    }
+
+    for(const auto& t: top) {
+        if(best_ever_log_likelihood < t.first) {
+            best_ever_particle = t.second;
+            best_ever_log_likelihood = t.first;
+        }
+    }
+
+    logger->info() << "# Optimum: log likelihood = "
+        << best_ever_log_likelihood.get_value() << ".";
+    save_best_particle();
+}
+
+template<class ModelType>
+unsigned int Sampler<ModelType>::mcmc_thread(unsigned int thread)
 {
 	// Reference to the RNG for this thread
 	RNG& rng = rngs[thread];
 
 	// Reference to this thread's copy of levels
-	std::vector<Level>& _levels = copies_of_levels[thread];
+	std::vector<Level>& _levels = thread_levels(thread);
 
 	// First particle belonging to this thread
 	const int start_index = thread*options.num_particles;
 
+	DNEST4_PROFILE(profile_counters(thread), Phase::mcmc);
+	DNEST4_TRACE(trace_buffer(thread), "mcmc");
+
 	// Do some MCMC
 	int which;
-	for(unsigned int i=0; i<options.thread_steps; ++i) {
+	unsigned int i = 0;
+#ifndef NO_PROFILING
+	unsigned int accepts = 0;
+#endif
+	for(; i<options.thread_steps; ++i) {
+		// Stop promptly if the process is about to be killed
+		if(drain_requested())
+			break;
+
 		which = start_index + rng.rand_int(options.num_particles);
+		LikelihoodType logl_before = log_likelihoods[which];
 
 		if(rng.rand() <= 0.5)
 		{
@@ -213,9 +551,25 @@ void Sampler<ModelType>::mcmc_thread(unsigned int thread)
 			update_particle(thread, which);
 		}
 		if(!enough_levels(_levels) && _levels.back().get_log_likelihood() < log_likelihoods[which]) {
-            above[thread].push_back(log_likelihoods[which]);
+            ((levels_in_place)?(all_above):(above[thread])).push_back(
+                                                    log_likelihoods[which]);
+        }
+		if(optimiser_mode && logl_before < log_likelihoods[which]) {
+            offer_top_particle(thread, which);
         }
+#ifndef NO_PROFILING
+		if(profiling && (logl_before < log_likelihoods[which] ||
+						 log_likelihoods[which] < logl_before))
+			++accepts;
+#endif
+	}
+#ifndef NO_PROFILING
+	if(profiling) {
+		phase_counters[thread].add_steps(i);
+		phase_counters[thread].add_accepts(accepts);
 	}
+#endif
+	return i;
 }
 
 template<class ModelType>
@@ -224,8 +578,8 @@ void Sampler<ModelType>::update_particle(unsigned int thread, unsigned int which
 	// Reference to the RNG for this thread
 	RNG& rng = rngs[thread];
 
-	// Reference to copies_of_levels[thread]
-	std::vector<Level>& _levels = copies_of_levels[thread];
+	// Reference to this thread's levels
+	std::vector<Level>& _levels = thread_levels(thread);
 
 	// Reference to the level we're in
 	Level& level = _levels[level_assignments[which]];
@@ -234,8 +588,72 @@ void Sampler<ModelType>::update_particle(unsigned int thread, unsigned int which
 	ModelType& particle = particles[which];
 	LikelihoodType& logl = log_likelihoods[which];
 
-	// Do the proposal for the particle
-	double log_H = particle.perturb(rng);
+    // Moves provided by the sampler, instead of perturb()
+    if(galilean_probability > 0. || slice_probability > 0. ||
+        ensemble_probability > 0.)
+    {
+        DNEST4_PROFILE(profile_counters(thread), Phase::moves);
+        double u = rng.rand();
+        bool done = true, moved = false;
+        if(u < galilean_probability)
+            moved = GalileanMove<ModelType>::move(particle, logl,
+                        level.get_log_likelihood(), galilean_steps,
+                        level_scale(galilean_log_step[thread],
+                                    level_assignments[which], log(0.1)),
+                        galilean_target, !enough_levels(_levels), rng,
+                        count_likelihood_evaluations[thread]);
+        else if((u -= galilean_probability) < slice_probability)
+            moved = SliceMove<ModelType>::move(particle, logl,
+                        level.get_log_likelihood(),
+                        level_scale(slice_log_width[thread],
+                                    level_assignments[which], log(0.1)),
+                        !enough_levels(_levels), rng,
+                        count_likelihood_evaluations[thread]);
+        else if((u -= slice_probability) < ensemble_probability)
+            done = ensemble_move(thread, which, moved);
+        else
+            done = false;
+
+        if(done)
+        {
+            if(moved)
+                level.increment_accepts(1);
+            level.increment_tries(1);
+            count_visits_and_exceeds(thread, which);
+            return;
+        }
+    }
+
+	// Several proposals at once, made from the unperturbed particle
+	if(num_tries > 1)
+	{
+		DNEST4_PROFILE(profile_counters(thread), Phase::moves);
+		if(multiple_try_move(thread, which))
+			level.increment_accepts(1);
+		level.increment_tries(1);
+		count_visits_and_exceeds(thread, which);
+		return;
+	}
+
+	// Do the proposal for the particle, scaled if proposal scaling is on
+	if(proposal_target > 0. && level_assignments[which] < log_proposal_scales.size())
+		rng.set_proposal_scale(exp(log_proposal_scales[level_assignments[which]]));
+	double log_H;
+	{
+		DNEST4_PROFILE(profile_counters(thread), Phase::perturb);
+		log_H = particle.perturb(rng);
+	}
+	rng.set_proposal_scale(1.);
+
+	// First stage of delayed acceptance, on the surrogate likelihood
+	double log_w_ratio = 0.;
+	if(delayed_acceptance)
+	{
+		log_w_ratio = DelayedAcceptance<ModelType>::log_weight_ratio(particle,
+									level.get_log_likelihood().get_value());
+		log_H += log_w_ratio;
+		++screening_counts[thread][0];
+	}
 
 	// Prevent unnecessary exponentiation of a large number
 	if(log_H > 0.0)
@@ -243,22 +661,177 @@ void Sampler<ModelType>::update_particle(unsigned int thread, unsigned int which
 
     if(rng.rand() <= exp(log_H))
     {
-    	LikelihoodType logl_proposal(particle.proposal_log_likelihood(),
-												logl.get_tiebreaker());
+        double value;
+        {
+            DNEST4_PROFILE(profile_counters(thread), Phase::likelihood);
+            value = particle.proposal_log_likelihood();
+        }
+    	LikelihoodType logl_proposal(value, logl.get_tiebreaker());
+        ++count_likelihood_evaluations[thread];
 
         // perturb likelihood to obtain new tiebreaker
         logl_proposal.perturb(rng);
 
+        // Second stage corrects for the first
+        bool passed = true;
+        if(delayed_acceptance)
+        {
+            ++screening_counts[thread][1];
+            passed = (log_w_ratio <= 0. || rng.rand() <= exp(-log_w_ratio));
+        }
+
 	    // Accept?
-	    if(level.get_log_likelihood() < logl_proposal)
+	    if(level.get_log_likelihood() < logl_proposal && passed)
 	    {
 		    particle.accept_perturbation();
 		    logl = logl_proposal;
 		    level.increment_accepts(1);
+		    if(delayed_acceptance)
+		        ++screening_counts[thread][2];
 	    }
     }
 
 	level.increment_tries(1);
+	count_visits_and_exceeds(thread, which);
+}
+
+/*
+* perturb() and its Hastings factor together make a move that leaves the
+* prior invariant, so use it as the proposal of a multiple-try Metropolis
+* move (Liu, Liang & Wong, 2000) with weights w(y, x) = 1 if y is above
+* the level and 0 otherwise. Rejected moves propose the particle itself.
+*/
+template<class ModelType>
+bool Sampler<ModelType>::multiple_try_move(unsigned int thread, unsigned int which)
+{
+	RNG& rng = rngs[thread];
+	const LikelihoodType& threshold =
+				thread_levels(thread)[level_assignments[which]].get_log_likelihood();
+	double scale = (proposal_target > 0. &&
+					level_assignments[which] < log_proposal_scales.size())?
+				(exp(log_proposal_scales[level_assignments[which]])):(1.);
+
+	// Proposals from the particle
+	std::vector<ModelType> tries(num_tries, particles[which]);
+	std::vector<LikelihoodType> logls(num_tries, log_likelihoods[which]);
+	std::vector<bool> valid, moved;
+	propose_tries(thread, tries, logls, valid, moved, threshold, scale);
+
+	// Choose one of the valid proposals
+	std::vector<unsigned int> candidates;
+	for(unsigned int j=0; j<num_tries; ++j)
+		if(valid[j])
+			candidates.push_back(j);
+	if(candidates.size() == 0)
+		return false;
+	unsigned int chosen = candidates[rng.rand_int(candidates.size())];
+	if(!moved[chosen])
+		return false;
+
+	// Proposals from the chosen one, plus the particle itself
+	std::vector<ModelType> reference(num_tries - 1, tries[chosen]);
+	std::vector<LikelihoodType> reference_logls(num_tries - 1, logls[chosen]);
+	propose_tries(thread, reference, reference_logls, valid, moved,
+				  threshold, scale);
+	unsigned int num_valid = 1;
+	for(unsigned int j=0; j<num_tries-1; ++j)
+		if(valid[j])
+			++num_valid;
+
+	if(rng.rand()*num_valid > candidates.size())
+		return false;
+	particles[which] = tries[chosen];
+	log_likelihoods[which] = logls[chosen];
+	return true;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::propose_tries(unsigned int thread,
+									   std::vector<ModelType>& tries,
+									   std::vector<LikelihoodType>& logls,
+									   std::vector<bool>& valid,
+									   std::vector<bool>& moved,
+									   const LikelihoodType& threshold,
+									   double scale)
+{
+	// Each proposal gets its own RNG, seeded from the thread's
+	RNG& rng = rngs[thread];
+	std::vector<unsigned int> seeds(tries.size());
+	for(auto& seed: seeds)
+		seed = rng.rand_int(std::numeric_limits<int>::max());
+
+	std::vector<char> is_valid(tries.size()), is_moved(tries.size());
+	pool->parallel_for(tries.size(), [&](size_t j)
+	{
+		RNG r(seeds[j]);
+		r.randh_is_randh2 = rng.randh_is_randh2;
+		r.set_proposal_scale(scale);
+
+		double log_H = tries[j].perturb(r);
+		if(log_H > 0.)
+			log_H = 0.;
+		is_moved[j] = (r.rand() <= exp(log_H));
+		if(is_moved[j])
+		{
+			LikelihoodType l(tries[j].proposal_log_likelihood(),
+								logls[j].get_tiebreaker());
+			l.perturb(r);
+			tries[j].accept_perturbation();
+			logls[j] = l;
+		}
+		is_valid[j] = !is_moved[j] || threshold < logls[j];
+	});
+
+	valid.assign(is_valid.begin(), is_valid.end());
+	moved.assign(is_moved.begin(), is_moved.end());
+	for(bool m: moved)
+		if(m)
+			++count_likelihood_evaluations[thread];
+}
+
+template<class ModelType>
+bool Sampler<ModelType>::ensemble_move(unsigned int thread, unsigned int which,
+                                       bool& moved)
+{
+    RNG& rng = rngs[thread];
+
+    // Particles of this thread which satisfy this particle's constraint
+    const unsigned int start_index = thread*options.num_particles;
+    std::vector<unsigned int> others;
+    for(unsigned int i=start_index; i<start_index+options.num_particles; ++i) {
+        if(i != which && level_assignments[i] >= level_assignments[which])
+            others.push_back(i);
+    }
+    if(others.size() < 2)
+        return false;
+
+    int j = rng.rand_int(others.size());
+    int k = rng.rand_int(others.size() - 1);
+    if(k >= j)
+        ++k;
+
+    const Level& level = thread_levels(thread)[level_assignments[which]];
+    moved = EnsembleMove<ModelType>::move(particles[which], log_likelihoods[which],
+                        level.get_log_likelihood(),
+                        particles[others[j]], particles[others[k]], rng,
+                        count_likelihood_evaluations[thread]);
+    return true;
+}
+
+template<class ModelType>
+double& Sampler<ModelType>::level_scale(std::vector<double>& scales,
+                                        unsigned int level, double initial)
+{
+    while(scales.size() <= level)
+        scales.push_back((scales.size() > 0)?(scales.back()):(initial));
+    return scales[level];
+}
+
+template<class ModelType>
+void Sampler<ModelType>::count_visits_and_exceeds(unsigned int thread,
+                                                  unsigned int which)
+{
+	std::vector<Level>& _levels = thread_levels(thread);
 
 	// Count visits and exceeds
 	unsigned int current_level = level_assignments[which];
@@ -276,11 +849,13 @@ void Sampler<ModelType>::update_particle(unsigned int thread, unsigned int which
 template<class ModelType>
 void Sampler<ModelType>::update_level_assignment(unsigned int thread,
 													unsigned int which) {
+    DNEST4_PROFILE(profile_counters(thread), Phase::level_assignment);
+
     // Reference to the RNG for this thread
     RNG &rng = rngs[thread];
 
     // Reference to this thread's copy of levels
-    std::vector<Level> &_levels = copies_of_levels[thread];
+    std::vector<Level> &_levels = thread_levels(thread);
 
     // Generate proposal
     int proposal = static_cast<int>(level_assignments[which])
@@ -324,13 +899,27 @@ void Sampler<ModelType>::update_level_assignment(unsigned int thread,
 template<class ModelType>
 void Sampler<ModelType>::run_thread(unsigned int thread)
 {
+	typedef std::chrono::steady_clock clock;
+	typedef std::chrono::duration<double> seconds;
+
+	// The model's parallel work goes to the sampler's pool
+	ThreadPool::Using using_pool(pool.get());
+
+	// A lone thread can work on the levels themselves, unless the
+	// coordinator needs the changes made in each round
+	levels_in_place = allow_levels_in_place && num_threads == 1 && !coordinator;
+
 	// Alternate between MCMC and bookkeeping
 	while(true)
 	{
+		auto round_start = clock::now();
+
 		// Thread zero takes full responsibility for some tasks
 		// Setting up copies of levels
-		if(thread == 0)
+		if(thread == 0 && !levels_in_place)
 		{
+			DNEST4_PROFILE(profile_counters(0), Phase::level_merge);
+
 			// Each thread will write over its own copy of the levels
 			for(unsigned int i=0; i<num_threads; ++i) {
                 copies_of_levels[i] = levels;
@@ -339,7 +928,11 @@ void Sampler<ModelType>::run_thread(unsigned int thread)
 
 #ifndef NO_THREADS
 		// Wait for all threads to get here before proceeding
-		barrier->wait();
+		{
+			DNEST4_PROFILE(profile_counters(thread), Phase::barrier);
+			DNEST4_TRACE(trace_buffer(thread), "barrier");
+			barrier->wait(pool.get());
+		}
 #endif
 
 		// Check for termination
@@ -349,51 +942,620 @@ void Sampler<ModelType>::run_thread(unsigned int thread)
 		}
 
 		// Do the MCMC (all threads do this!)
-		mcmc_thread(thread);
+		auto mcmc_start = clock::now();
+		round_steps[thread] = mcmc_thread(thread);
+		auto mcmc_end = clock::now();
 
 #ifndef NO_THREADS
-		barrier->wait();
+		{
+			DNEST4_PROFILE(profile_counters(thread), Phase::barrier);
+			DNEST4_TRACE(trace_buffer(thread), "barrier");
+			barrier->wait(pool.get());
+		}
 #endif
+		auto bookkeeping_start = clock::now();
+		mcmc_time[thread] += seconds(mcmc_end - mcmc_start).count();
+		barrier_time[thread] += seconds(bookkeeping_start - mcmc_end).count();
 
 		// Thread zero takes full responsibility for some tasks
 		if(thread == 0)
 		{
 			// Count the MCMC steps done
-			count_mcmc_steps += num_threads*options.thread_steps;
-            count_mcmc_steps_since_save += num_threads*options.thread_steps;
+			for(unsigned int steps: round_steps) {
+				count_mcmc_steps += steps;
+				count_mcmc_steps_since_save += steps;
+			}
 
 			// Go through copies of levels and apply diffs to levels
-			std::vector<Level> levels_orig = levels;
-			for(const auto& _levels: copies_of_levels)
+			std::vector<Level> levels_orig;
+			if(!levels_in_place)
 			{
-				for(size_t i=0; i<levels.size(); ++i)
+				DNEST4_PROFILE(profile_counters(0), Phase::level_merge);
+				levels_orig = levels;
+				for(const auto& _levels: copies_of_levels)
+				{
+					for(size_t i=0; i<levels.size(); ++i)
+					{
+						levels[i].increment_accepts(_levels[i].get_accepts()
+															- levels_orig[i].get_accepts());
+						levels[i].increment_tries(_levels[i].get_tries()
+															- levels_orig[i].get_tries());
+						levels[i].increment_visits(_levels[i].get_visits()
+															- levels_orig[i].get_visits());
+						levels[i].increment_exceeds(_levels[i].get_exceeds()
+															- levels_orig[i].get_exceeds());
+					}
+				}
+
+				// Combine into a single vector
+				for(auto& a: above)
 				{
-					levels[i].increment_accepts(_levels[i].get_accepts()
-														- levels_orig[i].get_accepts());
-					levels[i].increment_tries(_levels[i].get_tries()
-														- levels_orig[i].get_tries());
-					levels[i].increment_visits(_levels[i].get_visits()
-														- levels_orig[i].get_visits());
-					levels[i].increment_exceeds(_levels[i].get_exceeds()
-														- levels_orig[i].get_exceeds());
+					for(const auto& element: a) {
+						all_above.push_back(element);
+					}
+					a.clear();
 				}
 			}
 
-			// Combine into a single vector
-			for(auto& a: above)
-			{
-				for(const auto& element: a) {
-                    all_above.push_back(element);
-                }
-				a.clear();
+			// Save what we have as quickly as possible and stop
+			if(drain_requested()) {
+				if(!optimiser_mode)
+					save_checkpoint();
+				logger->info() << "# Drained after a termination request. "
+					<< "Checkpoint saved after " << count_mcmc_steps
+					<< " MCMC steps.";
+				logger->flush();
+				shouldThreadsStop = true;
+				continue;
 			}
 
+			// Levels are created by the coordinator, if there is one
+			if(coordinator)
+				exchange_levels(levels_orig);
+
 			// Do the bookkeeping
 			do_bookkeeping();
+			if(control)
+				apply_control();
+
+			auto round_end = clock::now();
+			bookkeeping_time += seconds(round_end - bookkeeping_start).count();
+			round_time += seconds(round_end - round_start).count();
+			++count_rounds_timed;
+			if(target_overhead > 0.)
+				tune_thread_steps();
 		}
 	}
 }
 
+template<class ModelType>
+void Sampler<ModelType>::set_galilean_moves(double probability,
+                                            unsigned int num_steps,
+                                            double target)
+{
+    if(!GalileanMove<ModelType>::available())
+        throw std::runtime_error("Galilean moves need a model with coordinates and a gradient.");
+    assert(probability >= 0. && probability <= 1.);
+    assert(num_steps >= 1 && target > 0. && target < 1.);
+    assert(probability + slice_probability + ensemble_probability <= 1.);
+    galilean_probability = probability;
+    galilean_steps = num_steps;
+    galilean_target = target;
+    galilean_log_step.resize(num_threads);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_slice_moves(double probability)
+{
+    if(!SliceMove<ModelType>::available())
+        throw std::runtime_error("slice moves need a model with coordinates.");
+    assert(probability >= 0. &&
+           galilean_probability + probability + ensemble_probability <= 1.);
+    slice_probability = probability;
+    slice_log_width.resize(num_threads);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_ensemble_moves(double probability)
+{
+    if(!EnsembleMove<ModelType>::available())
+        throw std::runtime_error("ensemble moves need a model with coordinates.");
+    assert(probability >= 0. &&
+           galilean_probability + slice_probability + probability <= 1.);
+    ensemble_probability = probability;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_multiple_tries(unsigned int num_tries,
+                                            unsigned int num_workers)
+{
+    assert(num_tries >= 1);
+    this->num_tries = num_tries;
+    if(num_tries > 1)
+        use_thread_pool(num_workers);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::use_thread_pool(unsigned int num_workers)
+{
+    if(num_workers == 0) {
+        if(pool)
+            return;
+        unsigned int cores = std::thread::hardware_concurrency();
+        num_workers = (cores > num_threads)?(cores - num_threads):(1);
+    }
+    if(!pool || pool->size() != num_workers)
+        pool = std::make_shared<ThreadPool>(num_workers);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_metrics(const std::string& filename,
+                                     const std::string& address,
+                                     double interval)
+{
+    metrics_file = filename;
+    metrics_interval = interval;
+    metrics_server.reset();
+    if(address != "") {
+        metrics_server = std::make_shared<MetricsServer>(address);
+        if(!metrics_server->is_listening()) {
+            logger->flush();
+            std::cerr << "error serving metrics at " << address
+                << " (it must be a local port, or a path that is free or"
+                << " holds a socket). Aborting" << std::endl;
+            exit(1);
+        }
+        logger->info() << "# Serving metrics at " << address << ".";
+    }
+    last_metrics = std::chrono::steady_clock::now();
+    last_metrics_steps = count_mcmc_steps;
+}
+
+template<class ModelType>
+std::string Sampler<ModelType>::metrics_text() const
+{
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - start_time).count();
+    double interval = std::chrono::duration<double>(now - last_metrics).count();
+
+    std::stringstream out;
+    out << std::setprecision(12);
+    auto metric = [&out](const char* name, const char* type, const char* help)
+    {
+        out << "# HELP dnest4_" << name << ' ' << help << '\n';
+        out << "# TYPE dnest4_" << name << ' ' << type << '\n';
+    };
+
+    metric("mcmc_steps_total", "counter", "MCMC steps done.");
+    out << "dnest4_mcmc_steps_total " << count_mcmc_steps << '\n';
+
+    metric("steps_per_second", "gauge",
+            "MCMC steps per second since the last update.");
+    out << "dnest4_steps_per_second ";
+    out << ((interval > 0.)?((count_mcmc_steps - last_metrics_steps)/interval):(0.));
+    out << '\n';
+
+    metric("likelihood_evaluations_total", "counter",
+            "Likelihood evaluations done by this process.");
+    out << "dnest4_likelihood_evaluations_total ";
+    out << get_count_likelihood_evaluations() << '\n';
+
+    metric("levels", "gauge", "Levels created so far.");
+    out << "dnest4_levels " << levels.size() << '\n';
+
+    metric("levels_done", "gauge", "1 once all levels have been created.");
+    out << "dnest4_levels_done " << ((enough_levels(levels))?(1):(0)) << '\n';
+
+    metric("difficulty", "gauge",
+            "How far the levels' exceedance fractions are from their targets.");
+    out << "dnest4_difficulty " << difficulty << '\n';
+
+    metric("work_ratio", "gauge", "Work ratio used to adapt the levels.");
+    out << "dnest4_work_ratio " << work_ratio << '\n';
+
+    metric("level_acceptance", "gauge",
+            "Fraction of proposals accepted at each level.");
+    for(size_t i=0; i<levels.size(); ++i) {
+        out << "dnest4_level_acceptance{level=\"" << i << "\"} ";
+        out << ((levels[i].get_tries() > 0)?
+                ((double)levels[i].get_accepts()/levels[i].get_tries()):(0.));
+        out << '\n';
+    }
+
+    metric("saves_total", "counter", "Particles saved.");
+    out << "dnest4_saves_total " << count_saves << '\n';
+
+    if(last_checkpoint_time != std::chrono::system_clock::time_point()) {
+        metric("last_checkpoint_timestamp_seconds", "gauge",
+                "Unix time of the last checkpoint.");
+        out << "dnest4_last_checkpoint_timestamp_seconds ";
+        out << std::chrono::duration<double>(
+                        last_checkpoint_time.time_since_epoch()).count() << '\n';
+    }
+
+    // From the steps per second of this run, and the time budget
+    double remaining = std::numeric_limits<double>::infinity();
+    double rate = (elapsed > 0.)?((count_mcmc_steps - start_steps)/elapsed):(0.);
+    if(options.max_num_saves > 0 && rate > 0.) {
+        double steps = (double)options.save_interval
+                            *(options.max_num_saves - std::min(count_saves,
+                                                    options.max_num_saves))
+                        - count_mcmc_steps_since_save;
+        remaining = std::max(steps, 0.)/rate;
+    }
+    if(stopping_rules.max_run_time > 0.)
+        remaining = std::min(remaining,
+                            std::max(stopping_rules.max_run_time - elapsed, 0.));
+    metric("estimated_seconds_remaining", "gauge",
+            "Estimated time until the run ends.");
+    out << "dnest4_estimated_seconds_remaining ";
+    if(std::isinf(remaining))
+        out << "+Inf";
+    else
+        out << remaining;
+    out << '\n';
+
+    return out.str();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::publish_metrics()
+{
+    std::string text = metrics_text();
+    last_metrics = std::chrono::steady_clock::now();
+    last_metrics_steps = count_mcmc_steps;
+
+    if(metrics_server)
+        metrics_server->publish(text);
+
+    if(metrics_file != "") {
+        std::string temp_name = metrics_file + ".next";
+        std::fstream fout(temp_name, std::ios::out);
+        if(fout.is_open()) {
+            fout << text;
+            fout.close();
+            std::rename(temp_name.c_str(), metrics_file.c_str());
+        }
+        else {
+            logger->error() << "error saving metrics. Continuing";
+        }
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_profiling(bool value, const std::string& filename,
+                                       double interval)
+{
+    profiling = value;
+    profile_file = filename;
+    profile_interval = interval;
+    phase_counters.resize(num_threads);
+    last_profile_write = std::chrono::steady_clock::now();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_tracing(bool value, const std::string& filename,
+                                     size_t capacity)
+{
+    tracing = value;
+    trace_file = filename;
+    trace_capacity = capacity;
+    trace_buffers.assign((tracing)?(num_threads):(0), TraceBuffer(capacity));
+}
+
+template<class ModelType>
+void Sampler<ModelType>::save_trace(const std::string& filename) const
+{
+    std::string temp_name = filename + ".next";
+    std::fstream fout(temp_name, std::ios::out);
+    if(fout.is_open()) {
+        write_chrome_trace(fout, trace_buffers);
+        fout.close();
+        std::rename(temp_name.c_str(), filename.c_str());
+    }
+    else {
+        logger->error() << "error saving trace. Continuing";
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::print_profile(std::ostream& out) const
+{
+    double elapsed = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_time).count();
+    PhaseCounters total;
+    for(const auto& counters: phase_counters)
+        total.add(counters);
+
+    out << std::fixed << std::setprecision(3);
+    out << "# Profile of " << num_threads << " thread";
+    out << ((num_threads > 1)?("s"):("")) << " after " << elapsed << " s";
+    out << std::endl;
+    out << "# phase, calls, seconds (all threads), percent of thread time";
+    out << std::endl;
+    for(size_t i=0; i<static_cast<size_t>(Phase::num_phases); ++i) {
+        Phase phase = static_cast<Phase>(i);
+        out << phase_name(phase) << ' ' << total.get_calls(phase) << ' ';
+        out << total.get_seconds(phase) << ' ';
+        out << 100.*total.get_seconds(phase)/(num_threads*elapsed) << std::endl;
+    }
+
+    out << "# thread, steps per second, likelihood evaluations per second, ";
+    out << "acceptance, percent idle at barriers" << std::endl;
+    for(size_t i=0; i<phase_counters.size(); ++i) {
+        const PhaseCounters& c = phase_counters[i];
+        out << i << ' ' << c.get_steps()/elapsed << ' ';
+        out << count_likelihood_evaluations[i]/elapsed << ' ';
+        out << ((c.get_steps() > 0)?((double)c.get_accepts()/c.get_steps()):(0.));
+        out << ' ' << 100.*c.get_seconds(Phase::barrier)/elapsed << std::endl;
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::save_profile()
+{
+    last_profile_write = std::chrono::steady_clock::now();
+    std::string temp_name = profile_file + ".next";
+    std::fstream fout(temp_name, std::ios::out);
+    if(fout.is_open()) {
+        print_profile(fout);
+        fout.close();
+        std::rename(temp_name.c_str(), profile_file.c_str());
+    }
+    else {
+        logger->error() << "error saving profile. Continuing";
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_delayed_acceptance(bool value)
+{
+    if(value && !DelayedAcceptance<ModelType>::available())
+        throw std::runtime_error("delayed acceptance needs a model with a surrogate likelihood.");
+    delayed_acceptance = value;
+    screening_counts.resize(num_threads);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::print_screening_rates() const
+{
+    unsigned long long int screened, passed, accepted;
+    get_screening_counts(screened, passed, accepted);
+    if(screened == 0)
+        return;
+
+    logger->info() << std::fixed << std::setprecision(1)
+        << "# Delayed acceptance: the surrogate stopped "
+        << 100.*(screened - passed)/screened << "% of " << screened
+        << " proposals, and the exact likelihood rejected "
+        << ((passed > 0)?(100.*(passed - accepted)/passed):(0.))
+        << "% of the rest.";
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_proposal_scaling(double target)
+{
+    assert(target > 0. && target < 1.);
+    proposal_target = target;
+    adapt_proposal_scales();
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_thread_steps_tuning(double target_overhead,
+                                                 unsigned int min_steps,
+                                                 unsigned int max_steps)
+{
+    assert(target_overhead > 0. && target_overhead < 1.);
+    assert(min_steps >= 1 && min_steps <= max_steps);
+    this->target_overhead = target_overhead;
+    min_thread_steps = min_steps;
+    max_thread_steps = max_steps;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::tune_thread_steps()
+{
+    // Average over enough rounds for the timings to mean something
+    if(count_rounds_timed < 5 || round_time < 0.1)
+        return;
+
+    double mcmc = 0., barrier = 0.;
+    for(unsigned int i=0; i<num_threads; ++i) {
+        mcmc += mcmc_time[i];
+        barrier += barrier_time[i];
+    }
+    mcmc /= num_threads*count_rounds_timed;
+    barrier /= num_threads*count_rounds_timed;
+    double bookkeeping = bookkeeping_time/count_rounds_timed;
+    double round = round_time/count_rounds_timed;
+    double overhead = std::max(1. - mcmc/round, 0.);
+
+    std::fill(mcmc_time.begin(), mcmc_time.end(), 0.);
+    std::fill(barrier_time.begin(), barrier_time.end(), 0.);
+    bookkeeping_time = 0.;
+    round_time = 0.;
+    count_rounds_timed = 0;
+
+    // While levels are being created, long rounds would let the level
+    // statistics go stale between bookkeeping steps
+    unsigned int cap = max_thread_steps;
+    if(!enough_levels(levels))
+        cap = std::max(min_thread_steps,
+                       std::min(max_thread_steps, options.new_level_interval));
+
+    // The time outside MCMC is roughly fixed per round, so aim for half the
+    // target (leaving room for noise), moving at most a factor of 2 at once
+    unsigned int steps = options.thread_steps;
+    if(overhead > target_overhead || overhead < 0.25*target_overhead) {
+        double goal = 0.5*target_overhead;
+        double wanted = (round - mcmc)*(1. - goal)/goal;
+        double factor = std::min(std::max(wanted/std::max(mcmc, 1E-9), 0.5), 2.);
+        steps = static_cast<unsigned int>(std::ceil(factor*steps));
+    }
+    steps = std::min(std::max(steps, min_thread_steps), cap);
+
+    if(steps != options.thread_steps) {
+        logger->info("thread_steps") << std::fixed << std::setprecision(1)
+            << "# Setting thread_steps = " << steps << " (overhead "
+            << 100.*overhead << "%; per round: MCMC "
+            << std::setprecision(6) << mcmc << " s, barrier "
+            << barrier << " s, bookkeeping " << bookkeeping << " s).";
+        options.thread_steps = steps;
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::connect_to_coordinator(const std::string& address)
+{
+    coordinator = std::make_shared<CoordinatorClient>(address);
+    if(!coordinator->is_connected()) {
+        logger->flush();
+        std::cerr << "error connecting to coordinator at " << address << ". Aborting" << std::endl;
+        exit(1);
+    }
+    logger->info() << "# Sharing levels through coordinator at " << address << ".";
+}
+
+template<class ModelType>
+void Sampler<ModelType>::set_control_file(const std::string& filename)
+{
+    control = std::make_shared<ControlFile>(filename);
+    logger->info() << "# Taking commands from " << filename << ".";
+}
+
+template<class ModelType>
+void Sampler<ModelType>::apply_control()
+{
+    std::vector< std::pair<std::string, std::string> > commands;
+    if(!control->poll(commands))
+        return;
+
+    for(const auto& command: commands) {
+        const std::string& name = command.first;
+        std::stringstream value(command.second);
+
+        if(name == "checkpoint" || name == "stop") {
+            if(!optimiser_mode) {
+                save_levels();
+                save_checkpoint();
+            }
+            if(name == "stop")
+                shouldThreadsStop = true;
+            logger->info() << "# Control: " << name << ".";
+            continue;
+        }
+        if(name == "trace") {
+            std::string filename = trace_file;
+            value >> filename;
+            if(tracing && filename != "") {
+                save_trace(filename);
+                logger->info() << "# Control: saved trace to " << filename << ".";
+            }
+            else
+                logger->warning() << "# Control: no trace to save.";
+            continue;
+        }
+        if(name == "flush") {
+            if(!optimiser_mode)
+                save_levels();
+            logger->info() << "# Control: flush.";
+            logger->flush();
+            continue;
+        }
+
+        // The rest are options which are safe to change between rounds
+        unsigned int* option = nullptr;
+        if(name == "save_interval")
+            option = &options.save_interval;
+        else if(name == "max_num_saves")
+            option = &options.max_num_saves;
+        else if(name == "thread_steps")
+            option = &options.thread_steps;
+        else if(name == "new_level_interval")
+            option = &options.new_level_interval;
+
+        if(option != nullptr) {
+            unsigned int n;
+            if(!(value >> n) || (n == 0 && name != "max_num_saves")) {
+                logger->warning() << "# Control: bad value for " << name << ".";
+                continue;
+            }
+            *option = n;
+            logger->info() << "# Control: " << name << " = " << n << ".";
+
+            // A manual choice overrides the automatic one
+            if(name == "thread_steps")
+                target_overhead = 0.;
+
+            // Don't wait for a count of saves that has already gone by
+            if(name == "max_num_saves" && n != 0 && count_saves >= n) {
+                save_levels();
+                save_checkpoint();
+                shouldThreadsStop = true;
+            }
+        }
+        else if(name == "thin") {
+            unsigned int n;
+            if(!(value >> n) || n == 0) {
+                logger->warning() << "# Control: bad value for thin.";
+                continue;
+            }
+            thin_print = n;
+            logger->info() << "# Control: thin = " << n << ".";
+        }
+        else if(name == "beta") {
+            double beta;
+            if(!(value >> beta) || beta < 0.) {
+                logger->warning() << "# Control: bad value for beta.";
+                continue;
+            }
+            options.beta = beta;
+            logger->info() << "# Control: beta = " << beta << ".";
+        }
+        else {
+            logger->warning() << "# Control: cannot change " << name
+                << " while running.";
+        }
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::exchange_levels(const std::vector<Level>& levels_orig)
+{
+    // Increments of the counters during this round
+    std::vector<Level> deltas;
+    for(size_t i=0; i<levels.size(); ++i) {
+        Level delta(levels[i].get_log_likelihood());
+        delta.increment_accepts(levels[i].get_accepts() - levels_orig[i].get_accepts());
+        delta.increment_tries(levels[i].get_tries() - levels_orig[i].get_tries());
+        delta.increment_visits(levels[i].get_visits() - levels_orig[i].get_visits());
+        delta.increment_exceeds(levels[i].get_exceeds() - levels_orig[i].get_exceeds());
+        deltas.push_back(delta);
+    }
+
+    std::vector<Level> shared_levels;
+    if(!coordinator->exchange(deltas, all_above, shared_levels) ||
+        shared_levels.size() < levels.size()) {
+        logger->warning() << "# Lost the coordinator. Continuing alone.";
+        coordinator.reset();
+        return;
+    }
+    all_above.clear();
+
+    size_t old_size = levels.size();
+    levels = shared_levels;
+    if(levels.size() > old_size) {
+        logger->info() << "# Received levels up to " << levels.size() - 1
+            << " from the coordinator.";
+        for(auto& a: above) {
+            a.clear();
+        }
+        if(!enough_levels(levels)) {
+            kill_lagging_particles();
+        }
+    }
+}
+
 template<class ModelType>
 void Sampler<ModelType>::increase_max_num_saves(unsigned int increment)
 {
@@ -405,50 +1567,67 @@ void Sampler<ModelType>::increase_max_num_saves(unsigned int increment)
 }
 
 template<class ModelType>
-bool Sampler<ModelType>::enough_levels(const std::vector<Level>& l) const
+void Sampler<ModelType>::adapt_proposal_scales()
 {
-    if(options.max_num_levels == 0)
-    {
-        // Check level spacing (in terms of log likelihood)
-        // over last n levels
-        int num_levels_to_check = static_cast<int>(30*sqrt(0.02*l.size()));
-        if(num_levels_to_check < 30)
-            return false;
-
-        int k = l.size() - 1;
-        double tot = 0.0;
-        double max = -1E300;
-        for(int i=0; i<num_levels_to_check; ++i)
-        {
-            double diff = l[k].get_log_likelihood().get_value()
-                             - l[k-1].get_log_likelihood().get_value();
-            tot += diff;
-            if(diff > max)
-                max = diff;
-            --k;
-        }
-        if(tot / num_levels_to_check < 0.75 && max < 1.0)
-            return true;
-        else
-            return false;
+    // New levels start from the scale of the one below
+    while(log_proposal_scales.size() < levels.size()) {
+        log_proposal_scales.push_back((log_proposal_scales.size() > 0)?
+                                      (log_proposal_scales.back()):(0.));
+    }
+    // Rates are measured from when a level is first seen here
+    for(size_t i=proposal_tries.size(); i<levels.size(); ++i) {
+        proposal_accepts.push_back(levels[i].get_accepts());
+        proposal_tries.push_back(levels[i].get_tries());
     }
 
-    // Just compare with the value from OPTIONS
-    return (l.size() >= options.max_num_levels);
+    // Fixed once the levels are, so that the moves keep their targets
+    if(enough_levels(levels))
+        return;
+
+    for(size_t i=0; i<levels.size(); ++i) {
+        if(levels[i].get_tries() < proposal_tries[i]) {
+            proposal_accepts[i] = levels[i].get_accepts();
+            proposal_tries[i] = levels[i].get_tries();
+            continue;
+        }
+
+        // Wait for enough tries to tell the rate
+        unsigned long long int tries = levels[i].get_tries() - proposal_tries[i];
+        if(tries < 100)
+            continue;
+        double rate = (double)(levels[i].get_accepts() - proposal_accepts[i])/tries;
+        log_proposal_scales[i] += rate - proposal_target;
+        log_proposal_scales[i] = std::min(std::max(log_proposal_scales[i],
+                                                   log(1E-6)), log(10.));
+        proposal_accepts[i] = levels[i].get_accepts();
+        proposal_tries[i] = levels[i].get_tries();
+    }
+}
+
+template<class ModelType>
+bool Sampler<ModelType>::enough_levels(const std::vector<Level>& l) const
+{
+    return Level::enough_levels(l, options.max_num_levels);
 }
 
 template<class ModelType>
 void Sampler<ModelType>::do_bookkeeping()
 {
+	DNEST4_PROFILE(profile_counters(0), Phase::bookkeeping);
+	DNEST4_TRACE(trace_buffer(0), "bookkeeping");
+
 	// Create a new level?
 	if(!enough_levels(levels) &&
         (all_above.size() >= options.new_level_interval))
 	{
+		DNEST4_PROFILE(profile_counters(0), Phase::level_creation);
+		DNEST4_TRACE(trace_buffer(0), "level_creation");
+
 		// Create the level
 		std::sort(all_above.begin(), all_above.end());
 		int index = static_cast<int>((1. - 1./compression)*all_above.size());
-		std::cout<<"# Creating level "<<levels.size()<<" with log likelihood = ";
-		std::cout<<all_above[index].get_value()<<"."<<std::endl;
+		logger->info()<<"# Creating level "<<levels.size()<<" with log likelihood = "
+			<<all_above[index].get_value()<<".";
 
 		levels.push_back(Level(all_above[index]));
 		all_above.erase(all_above.begin(), all_above.begin() + index + 1);
@@ -463,7 +1642,7 @@ void Sampler<ModelType>::do_bookkeeping()
             double reg = options.new_level_interval*sqrt(options.lambda);
 			Level::renormalise_visits(levels, static_cast<int>(reg));
 			all_above.clear();
-            std::cout<<"# Done creating levels."<<std::endl;
+            logger->info()<<"# Done creating levels.";
 		}
 		else
 		{
@@ -476,6 +1655,8 @@ void Sampler<ModelType>::do_bookkeeping()
 	Level::recalculate_log_X(levels, compression,
                         options.new_level_interval*sqrt(options.lambda));
 
+    if(proposal_target > 0.)
+        adapt_proposal_scales();
 
     if(!enough_levels(levels) && adaptive)
     {
@@ -504,17 +1685,186 @@ void Sampler<ModelType>::do_bookkeeping()
             work_ratio = 1.0;
     }
 
+	bool saved = false;
 	if(count_mcmc_steps_since_save >= options.save_interval) {
+        saved = true;
         ++count_saves;
+        check_adopted_levels();
         count_mcmc_steps_since_save = 0;
-        save_levels();
-        save_particle();
-        save_checkpoint();
-        auto indices = argsort(log_likelihoods);
-        if (best_ever_log_likelihood < log_likelihoods[indices.back()]) {
-            best_ever_particle = particles[indices.back()];
-            best_ever_log_likelihood = log_likelihoods[indices.back()];
-            save_best_particle();
+
+        // The optimiser only writes out its result at the end
+        if(!optimiser_mode) {
+            save_levels();
+            save_particle();
+            save_checkpoint();
+            auto indices = argsort(log_likelihoods);
+            if (best_ever_log_likelihood < log_likelihoods[indices.back()]) {
+                best_ever_particle = particles[indices.back()];
+                best_ever_log_likelihood = log_likelihoods[indices.back()];
+                save_best_particle();
+            }
+        }
+
+        if(delayed_acceptance && count_saves%100 == 0)
+            print_screening_rates();
+    }
+
+    // End the run early, leaving a checkpoint to continue from
+    if(check_stopping_rules(saved)) {
+        shouldThreadsStop = true;
+        if(!optimiser_mode) {
+            save_levels();
+            save_checkpoint();
+        }
+    }
+
+    if(profiling && profile_file != "" &&
+        std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                - last_profile_write).count() >= profile_interval)
+        save_profile();
+
+    if((metrics_file != "" || metrics_server) &&
+        std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                - last_metrics).count() >= metrics_interval)
+        publish_metrics();
+}
+
+template<class ModelType>
+bool Sampler<ModelType>::check_stopping_rules(bool saved)
+{
+    if(stopping_rules.max_run_time > 0.) {
+        std::chrono::duration<double> elapsed =
+                            std::chrono::steady_clock::now() - start_time;
+        if(elapsed.count() >= stopping_rules.max_run_time) {
+            logger->info() << "# Stopping: used the time budget of "
+                << stopping_rules.max_run_time << " s.";
+            return true;
+        }
+    }
+
+    if(stopping_rules.max_num_likelihood_evaluations > 0 &&
+        get_count_likelihood_evaluations() >=
+                        stopping_rules.max_num_likelihood_evaluations) {
+        logger->info() << "# Stopping: used the budget of "
+            << stopping_rules.max_num_likelihood_evaluations
+            << " likelihood evaluations.";
+        return true;
+    }
+
+    // The estimates only mean something once all levels exist,
+    // and only change when a particle is saved
+    if(!enough_levels(levels)) {
+        log_Z_history.clear();
+        last_estimate_saves = 0;
+        return false;
+    }
+    if(!saved || !stopping_rules.need_estimates())
+        return false;
+
+    if(!saved_log_likelihoods_loaded)
+        load_saved_log_likelihoods();
+
+    // Estimates cost O(N log N) in the number of saves, so make them
+    // every 1% of the saves rather than at each one
+    size_t num_saved = saved_log_likelihoods.size();
+    if(last_estimate_saves > 0 &&
+        num_saved < last_estimate_saves + std::max<size_t>(1, last_estimate_saves/100))
+        return false;
+    last_estimate_saves = num_saved;
+
+    double log_Z, ess;
+    estimate_log_Z(log_Z, ess);
+    log_Z_history.push_back(log_Z);
+
+    if(stopping_rules.target_ess > 0. && ess >= stopping_rules.target_ess) {
+        logger->info() << "# Stopping: effective sample size " << ess
+            << " reached the target of " << stopping_rules.target_ess << ".";
+        return true;
+    }
+
+    size_t window = std::max(stopping_rules.log_Z_window, 1u);
+    if(stopping_rules.log_Z_tolerance > 0. && log_Z_history.size() >= window) {
+        auto range = std::minmax_element(log_Z_history.end() - window,
+                                         log_Z_history.end());
+        if(*range.second - *range.first <= stopping_rules.log_Z_tolerance) {
+            logger->info() << "# Stopping: log(Z) = " << log_Z
+                << " has been stable to within "
+                << stopping_rules.log_Z_tolerance << " over the last "
+                << window << " estimates.";
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::estimate_log_Z(double& log_Z, double& ess) const
+{
+    std::vector<double> levels_log_X;
+    for(const Level& level: levels) {
+        levels_log_X.push_back(level.get_log_X());
+    }
+
+    std::vector<double> log_post;
+    log_Z = RunMerger::integrate(levels, levels_log_X, saved_log_likelihoods,
+                                 log_post);
+
+    // exp of the entropy of the posterior weights
+    double entropy = 0.;
+    for(double lp: log_post) {
+        if(lp != -std::numeric_limits<double>::infinity()) {
+            entropy -= exp(lp)*lp;
+        }
+    }
+    ess = exp(entropy);
+}
+
+template<class ModelType>
+unsigned long long int Sampler<ModelType>::get_count_likelihood_evaluations() const
+{
+    unsigned long long int total = 0;
+    for(auto count: count_likelihood_evaluations) {
+        total += count;
+    }
+    return total;
+}
+
+template<class ModelType>
+void Sampler<ModelType>::get_screening_counts(unsigned long long int& screened,
+                                              unsigned long long int& passed,
+                                              unsigned long long int& accepted) const
+{
+    screened = passed = accepted = 0;
+    for(const auto& counts: screening_counts) {
+        screened += counts[0];
+        passed += counts[1];
+        accepted += counts[2];
+    }
+}
+
+template<class ModelType>
+void Sampler<ModelType>::check_adopted_levels()
+{
+    // Only levels inherited from a warm start need checking; the usual
+    // ones are placed using the samples from this run
+    for(size_t i=0; i+1<num_adopted_levels; ++i)
+    {
+        if(std::find(inconsistent_levels.begin(), inconsistent_levels.end(), i+1)
+                != inconsistent_levels.end())
+            continue;
+
+        // Wait for enough visits to say something
+        if(levels[i].get_visits() < options.new_level_interval)
+            continue;
+
+        // Compare the measured compression with the target
+        double log_ratio = log((double)(levels[i].get_exceeds() + 1)
+                                /(double)(levels[i].get_visits() + 1));
+        if(std::abs(log_ratio + log(compression)) > log(compression))
+        {
+            inconsistent_levels.push_back(i+1);
+            logger->warning() << "# WARNING: Adopted level " << i + 1 << " has compression "
+                << exp(-log_ratio) << " (target " << compression << ").";
         }
     }
 }
@@ -534,7 +1884,7 @@ double Sampler<ModelType>::log_push(unsigned int which_level) const
 template<class ModelType>
 void Sampler<ModelType>::initialise_output_files() const
 {
-	if(!save_to_disk)
+	if(!save_to_disk || optimiser_mode)
 		return;
 
 	std::fstream fout;
@@ -557,6 +1907,8 @@ void Sampler<ModelType>::save_levels() const
 {
 	if(!save_to_disk)
 		return;
+	DNEST4_PROFILE(profile_counters(0), Phase::save_levels);
+	DNEST4_TRACE(trace_buffer(0), "save_levels");
 
 	// Output file
 	std::fstream fout;
@@ -609,10 +1961,17 @@ void Sampler<ModelType>::save_best_particle() const
 template<class ModelType>
 void Sampler<ModelType>::save_particle()
 {
-	if(!save_to_disk)
+	if(!save_to_disk && !stopping_rules.need_estimates())
 		return;
+	DNEST4_PROFILE(profile_counters(0), Phase::save_particle);
+	DNEST4_TRACE(trace_buffer(0), "save_particle");
 
 	int which = rngs[0].rand_int(particles.size());
+	if(stopping_rules.need_estimates())
+		saved_log_likelihoods.push_back(log_likelihoods[which]);
+	if(!save_to_disk)
+		return;
+
     std::fstream fout;
     fout.open(options.sample_file, std::ios::out|std::ios::app);
     if(options.write_exact_representation) {
@@ -638,13 +1997,15 @@ void Sampler<ModelType>::save_particle()
 	fout<<log_likelihoods[which].get_tiebreaker()<<' ';
 	fout<<which<<std::endl;
 	fout.close();
+
+	if(count_saves%thin_print == 0)
+		logger->info("saves")<<"# Saving particle to disk. N = "<<count_saves<<".";
 }
 
 template<class ModelType>
 void Sampler<ModelType>::kill_lagging_particles()
 {
-	// Count the number of deletions
-	static unsigned int deletions = 0;
+	DNEST4_TRACE(trace_buffer(0), "kill_lagging_particles");
 
 	// Flag each particle as good or bad
 	std::vector<bool> good(num_threads*options.num_particles, true);
@@ -685,13 +2046,11 @@ void Sampler<ModelType>::kill_lagging_particles()
 
 				particles[i] = particles[i_copy];
 				log_likelihoods[i] = log_likelihoods[i_copy];
-                std::cout << "writing all above as" << std::endl;
 				level_assignments[i] = level_assignments[i_copy];
-				++deletions;
+				++num_deletions;
 
-				std::cout<<"# Replacing lagging particle.";
-				std::cout<<" This has happened "<<deletions;
-				std::cout<<" times."<<std::endl;
+				logger->info("lagging")<<"# Replacing lagging particle."
+					<<" This has happened "<<num_deletions<<" times.";
 			}
 		}
 	}
@@ -744,6 +2103,11 @@ void Sampler<ModelType>::print(std::ostream& out) const
     for (const auto& r : rngs) {
         r.engine.serialize(out);
     }
+
+    out << ' ' << log_proposal_scales.size() << ' ';
+    for(double s: log_proposal_scales) {
+        out << s << ' ';
+    }
 }
 
 template<class ModelType>
@@ -764,18 +2128,28 @@ void Sampler<ModelType>::read(std::istream& in)
     work_ratio = std::strtod(work_ratio_string.c_str(), NULL);
 
     in>>save_to_disk;
-    in>>num_threads;
+    // The running sampler keeps its own thread count; reshard() below
+    // maps the checkpoint onto it
+    unsigned int saved_num_threads;
+    in>>saved_num_threads;
+    if(num_threads == 0) {
+        num_threads = saved_num_threads;
+        options.num_particles = 0;
+    }
     // doubles written in hexfloat format to avoid loss of precision
     // correctly parsing hexfloat requires a temporary string and std::strtod
     std::string temp_string;
     in>>temp_string;
     compression = std::strtod(temp_string.c_str(), NULL);
 
+    // New particles start as copies of an existing one so they keep
+    // whatever the prototype gave them (e.g. a dataset)
+    ModelType prototype = (particles.size() > 0) ? (particles[0]) : (ModelType());
     size_t num_particles;
     in >> num_particles;
     particles.clear();
     for(size_t i=0; i<num_particles;++i) {
-        ModelType p;
+        ModelType p = prototype;
         p.read(in);
         p.read_internal(in);
         particles.push_back(p);
@@ -820,9 +2194,132 @@ void Sampler<ModelType>::read(std::istream& in)
     size_t num_rngs;
     in >> num_rngs;
     in.get();  // To consume the space after num_rngs
+    bool randh_is_randh2 = (rngs.size() > 0) && rngs[0].randh_is_randh2;
+    rngs.resize(num_rngs);
     for (size_t i = 0; i < num_rngs; ++i) {
+        rngs[i].randh_is_randh2 = randh_is_randh2;
         rngs[i].engine = hops::RandomNumberGenerator::deserialize(in);
     }
+
+    // Older checkpoints end before the proposal scales
+    size_t num_scales;
+    log_proposal_scales.clear();
+    if(in >> num_scales) {
+        for(size_t i=0; i<num_scales; ++i) {
+            in >> temp_string;
+            log_proposal_scales.push_back(std::strtod(temp_string.c_str(), NULL));
+        }
+    }
+    proposal_accepts.clear();
+    proposal_tries.clear();
+
+    reshard(saved_num_threads);
+}
+
+template<class ModelType>
+void Sampler<ModelType>::reshard(unsigned int saved_num_threads)
+{
+    // Nothing to do if the layout already matches (or was adopted as-is)
+    size_t num_particles = options.num_particles*num_threads;
+    if(options.num_particles == 0 ||
+        (saved_num_threads == num_threads && particles.size() == num_particles))
+    {
+        options.num_particles = particles.size()/num_threads;
+        rngs.resize(num_threads);
+        count_likelihood_evaluations.resize(num_threads, 0);
+        screening_counts.resize(num_threads);
+        phase_counters.resize(num_threads);
+        if(tracing)
+            trace_buffers.resize(num_threads, TraceBuffer(trace_capacity));
+        top_particles.resize(num_threads);
+        mcmc_time.resize(num_threads, 0.);
+        barrier_time.resize(num_threads, 0.);
+        round_steps.resize(num_threads, 0);
+        galilean_log_step.resize(num_threads);
+        slice_log_width.resize(num_threads);
+        threads.resize(num_threads, nullptr);
+        copies_of_levels = std::vector< std::vector<Level> >(num_threads, levels);
+        above.resize(num_threads);
+        return;
+    }
+
+    logger->info() << "# Resharding " << particles.size() << " particles on "
+        << saved_num_threads << " threads to " << num_particles
+        << " particles on " << num_threads << " threads.";
+
+    // Derive any extra RNG streams deterministically from the saved ones
+    size_t num_saved_rngs = rngs.size();
+    assert(num_saved_rngs > 0);
+    rngs.resize(num_threads);
+    for(size_t i=num_saved_rngs; i<rngs.size(); ++i) {
+        RNG& parent = rngs[i % num_saved_rngs];
+        rngs[i].randh_is_randh2 = parent.randh_is_randh2;
+        rngs[i].set_seed(static_cast<unsigned int>(
+                    std::numeric_limits<unsigned int>::max()*parent.rand()));
+    }
+
+    // Select particles with probability proportional to their level push.
+    // Every saved particle is kept once if there is room for it.
+    double max_log_push = -std::numeric_limits<double>::max();
+    for(size_t i=0; i<particles.size(); ++i)
+        max_log_push = std::max(max_log_push, log_push(level_assignments[i]));
+
+    std::vector<size_t> chosen;
+    if(num_particles < particles.size()) {
+        // Subsampling draws without replacement: keep the particles with
+        // the largest u^(1/push), i.e. the smallest log(-log(u)) - log(push),
+        // which doesn't underflow however small the push
+        std::vector<double> keys(particles.size());
+        for(size_t i=0; i<particles.size(); ++i) {
+            keys[i] = log(-log(rngs[0].rand()))
+                        - (log_push(level_assignments[i]) - max_log_push);
+            chosen.push_back(i);
+        }
+        std::partial_sort(chosen.begin(), chosen.begin() + num_particles,
+                          chosen.end(),
+                          [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+        chosen.resize(num_particles);
+    }
+    else {
+        for(size_t i=0; i<particles.size(); ++i)
+            chosen.push_back(i);
+    }
+    while(chosen.size() < num_particles) {
+        size_t i = rngs[0].rand_int(particles.size());
+        if(rngs[0].rand() < exp(log_push(level_assignments[i]) - max_log_push))
+            chosen.push_back(i);
+    }
+
+    std::vector<ModelType> new_particles;
+    std::vector<LikelihoodType> new_log_likelihoods;
+    std::vector<unsigned int> new_level_assignments;
+    for(size_t i: chosen) {
+        new_particles.push_back(particles[i]);
+        new_log_likelihoods.push_back(log_likelihoods[i]);
+        new_level_assignments.push_back(level_assignments[i]);
+    }
+    particles = new_particles;
+    log_likelihoods = new_log_likelihoods;
+    level_assignments = new_level_assignments;
+
+    // Per-thread storage
+    threads.resize(num_threads, nullptr);
+    count_likelihood_evaluations.resize(num_threads, 0);
+    screening_counts.resize(num_threads);
+    phase_counters.resize(num_threads);
+    if(tracing)
+        trace_buffers.resize(num_threads, TraceBuffer(trace_capacity));
+    top_particles.resize(num_threads);
+    mcmc_time.resize(num_threads, 0.);
+    barrier_time.resize(num_threads, 0.);
+    round_steps.resize(num_threads, 0);
+    galilean_log_step.resize(num_threads);
+    slice_log_width.resize(num_threads);
+    copies_of_levels = std::vector< std::vector<Level> >(num_threads, levels);
+    above = std::vector< std::vector<LikelihoodType> >(num_threads);
+    for(auto& a: above) {
+        a.reserve(2 * options.new_level_interval);
+    }
 }
 
 } // namespace DNest4
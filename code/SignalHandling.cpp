@@ -0,0 +1,61 @@
+#include "SignalHandling.h"
+#include <csignal>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace DNest4
+{
+
+// Only this may be touched by the handler
+static volatile std::sig_atomic_t drain_flag = 0;
+static unsigned int drain_deadline = 0;
+static bool handler_installed = false;
+
+extern "C" void drain_handler(int signal)
+{
+	drain_flag = 1;
+
+	// Next time, die as usual
+	std::signal(signal, SIG_DFL);
+
+#ifndef _WIN32
+	if(drain_deadline > 0)
+		alarm(drain_deadline);
+#endif
+}
+
+void install_drain_handler(unsigned int deadline)
+{
+	drain_deadline = deadline;
+	handler_installed = true;
+	reset_drain();
+}
+
+bool drain_requested()
+{
+	return drain_flag != 0;
+}
+
+void request_drain()
+{
+	drain_flag = 1;
+}
+
+void reset_drain()
+{
+	drain_flag = 0;
+	if(!handler_installed)
+		return;
+
+#ifndef _WIN32
+	// Cancel the deadline of the drain just served
+	if(drain_deadline > 0)
+		alarm(0);
+#endif
+	std::signal(SIGTERM, drain_handler);
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,30 @@
+#ifndef DNest4_SignalHandling
+#define DNest4_SignalHandling
+
+namespace DNest4
+{
+
+/*
+* Draining on SIGTERM, for nodes which are taken away at short notice.
+* The handler only sets a flag. Running samplers stop within one MCMC
+* step of seeing it, write a checkpoint and return from run(). If that
+* takes longer than 'deadline' seconds, SIGALRM ends the process.
+* A second SIGTERM ends the process at once. Installing the handler
+* clears any earlier request.
+*/
+void install_drain_handler(unsigned int deadline=25);
+
+// Has a drain been requested (by a signal or request_drain())?
+bool drain_requested();
+
+// Ask running samplers to drain, as SIGTERM does
+void request_drain();
+
+// Forget a request once it has been served, so that later runs in the
+// same process don't drain at once. Re-arms the handler if installed.
+void reset_drain();
+
+} // namespace DNest4
+
+#endif
+
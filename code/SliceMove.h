@@ -0,0 +1,179 @@
+#ifndef DNest4_SliceMove
+#define DNest4_SliceMove
+
+#include <cmath>
+#include <vector>
+#include "LikelihoodType.h"
+#include "ModelTraits.h"
+#include "RNG.h"
+
+namespace DNest4
+{
+
+/*
+* Slice sampling inside a level (Neal, 2003). Within a level the target
+* is uniform over the part of the unit hypercube above the threshold, so
+* a slice along a line is just the part of the line inside that region.
+* The interval is stepped out from the current point and shrunk towards
+* it until a point inside is found, which always succeeds and needs no
+* tuning beyond a rough width. Needs the coordinate interface described
+* in ModelTraits.h.
+*/
+template<class ModelType, bool = has_coordinates<ModelType>::value>
+class SliceMove
+{
+	public:
+		static bool available()
+		{ return false; }
+
+		static bool move(ModelType&, LikelihoodType&, const LikelihoodType&,
+						double&, bool, RNG&, unsigned long long int&)
+		{ return false; }
+};
+
+template<class ModelType>
+class SliceMove<ModelType, true>
+{
+	private:
+		// Is u inside the hypercube and above the threshold?
+		static bool inside(ModelType& particle, const std::vector<double>& u,
+							const LikelihoodType& threshold, double tiebreaker,
+							double& log_likelihood,
+							unsigned long long int& count_evaluations)
+		{
+			for(double ui: u)
+				if(ui < 0. || ui > 1.)
+					return false;
+			particle.set_coordinates(u);
+			++count_evaluations;
+			log_likelihood = particle.log_likelihood();
+			return threshold < LikelihoodType(log_likelihood, tiebreaker);
+		}
+
+	public:
+		static bool available()
+		{ return true; }
+
+		// Move the particle along a random coordinate or direction,
+		// staying above 'threshold'. If 'adapt', the initial interval
+		// width exp(log_width) is adapted so that stepping out and
+		// shrinking happen about equally often. Returns whether the
+		// particle moved.
+		static bool move(ModelType& particle, LikelihoodType& logl,
+						const LikelihoodType& threshold, double& log_width,
+						bool adapt, RNG& rng,
+						unsigned long long int& count_evaluations)
+		{
+			std::vector<double> u0, u;
+			particle.get_coordinates(u0);
+			const size_t n = u0.size();
+			const double tiebreaker = logl.get_tiebreaker();
+
+			// Along one coordinate or a random direction
+			std::vector<double> d(n, 0.);
+			if(rng.rand() <= 0.5)
+				d[rng.rand_int(n)] = 1.;
+			else
+			{
+				double norm = 0.;
+				for(double& di: d)
+				{
+					di = rng.randn();
+					norm += di*di;
+				}
+				norm = std::sqrt(norm);
+				for(double& di: d)
+					di /= norm;
+			}
+			auto point = [&](double t)
+			{
+				u = u0;
+				for(size_t i=0; i<n; ++i)
+					u[i] += t*d[i];
+			};
+
+			// Place the interval at random around the current point and
+			// step out until both ends are outside. The step limit is split
+			// at random between the two ends, as in Neal's Fig. 3, so that
+			// the interval is the same whichever point in it we start from.
+			double w = std::exp(log_width);
+			double a = -w*rng.rand();
+			double b = a + w;
+			double log_likelihood = logl.get_value();
+			int expansions = 0, shrinks = 0;
+			const int max_expansions = 100;
+			int left = static_cast<int>(std::floor(max_expansions*rng.rand()));
+			int right = max_expansions - 1 - left;
+			point(a);
+			while(left > 0 &&
+				inside(particle, u, threshold, tiebreaker, log_likelihood,
+						count_evaluations))
+			{
+				a -= w;
+				point(a);
+				--left;
+				++expansions;
+			}
+			point(b);
+			while(right > 0 &&
+				inside(particle, u, threshold, tiebreaker, log_likelihood,
+						count_evaluations))
+			{
+				b += w;
+				point(b);
+				--right;
+				++expansions;
+			}
+
+			// Shrink towards the current point
+			bool moved = false;
+			while(b - a > 1E-12*w)
+			{
+				double t = a + (b - a)*rng.rand();
+				point(t);
+				if(inside(particle, u, threshold, tiebreaker, log_likelihood,
+							count_evaluations))
+				{
+					moved = true;
+					break;
+				}
+				++shrinks;
+				if(t < 0.)
+					a = t;
+				else
+					b = t;
+			}
+
+			// Keep the width between a millionth of the hypercube and all
+			// of it, so that it can't collapse onto the current point
+			if(adapt)
+			{
+				log_width += 0.1*(expansions - shrinks)
+								/(expansions + shrinks + 1.);
+				if(log_width > 0.)
+					log_width = 0.;
+				if(log_width < std::log(1E-6))
+					log_width = std::log(1E-6);
+			}
+
+			if(!moved)
+			{
+				particle.set_coordinates(u0);
+				return false;
+			}
+
+			// Perturb the tiebreaker, as for any other move
+			LikelihoodType logl_new(log_likelihood, tiebreaker);
+			logl_new.perturb(rng);
+			if(threshold < logl_new)
+				logl = logl_new;
+			else
+				logl = LikelihoodType(log_likelihood, tiebreaker);
+			return true;
+		}
+};
+
+} // namespace DNest4
+
+#endif
+
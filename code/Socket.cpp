@@ -0,0 +1,396 @@
+#include "Socket.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Writing to a closed connection should fail, not raise SIGPIPE
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace DNest4
+{
+
+Socket::Socket()
+:fd(-1)
+{
+
+}
+
+Socket::Socket(int fd)
+:fd(fd)
+{
+
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+Socket::Socket(Socket&& other)
+:fd(other.fd)
+,pending(std::move(other.pending))
+{
+	other.fd = -1;
+}
+
+Socket& Socket::operator = (Socket&& other)
+{
+	if(this != &other)
+	{
+		close();
+		fd = other.fd;
+		pending = std::move(other.pending);
+		other.fd = -1;
+	}
+	return *this;
+}
+
+#ifndef _WIN32
+
+Socket Socket::listen(const std::string& host, unsigned short port)
+{
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	addrinfo* result = nullptr;
+	std::stringstream s;
+	s<<port;
+	if(getaddrinfo(host.c_str(), s.str().c_str(), &hints, &result) != 0)
+		throw std::runtime_error("could not resolve " + host + ".");
+
+	int fd = -1;
+	for(addrinfo* a = result; a != nullptr; a = a->ai_next)
+	{
+		fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+		if(fd < 0)
+			continue;
+
+		int yes = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		if(::bind(fd, a->ai_addr, a->ai_addrlen) == 0 && ::listen(fd, 64) == 0)
+			break;
+		::close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(result);
+
+	if(fd < 0)
+		throw std::runtime_error("could not listen on port.");
+	return Socket(fd);
+}
+
+Socket Socket::listen_local(const std::string& address)
+{
+	// Anything that parses as host:port is a TCP address, and only a
+	// loopback one will do
+	std::string host;
+	unsigned short port;
+	if(parse_address(address, host, port))
+	{
+		if(host != "localhost" && host != "127.0.0.1")
+			return Socket();
+
+		int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+		if(fd < 0)
+			return Socket();
+
+		int yes = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+		sockaddr_in addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(port);
+		if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+			::listen(fd, 16) != 0)
+		{
+			::close(fd);
+			return Socket();
+		}
+		return Socket(fd);
+	}
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(address.size() == 0 || address.size() >= sizeof(addr.sun_path))
+		return Socket();
+	std::strcpy(addr.sun_path, address.c_str());
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+		return Socket();
+
+	// Replace a socket left behind by an earlier run, but nothing else
+	remove_socket_file(address);
+	if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		::listen(fd, 16) != 0)
+	{
+		::close(fd);
+		return Socket();
+	}
+	return Socket(fd);
+}
+
+Socket Socket::connect(const std::string& host, unsigned short port)
+{
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	std::stringstream s;
+	s<<port;
+	if(getaddrinfo(host.c_str(), s.str().c_str(), &hints, &result) != 0)
+		return Socket();
+
+	int fd = -1;
+	for(addrinfo* a = result; a != nullptr; a = a->ai_next)
+	{
+		fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+		if(fd < 0)
+			continue;
+		if(::connect(fd, a->ai_addr, a->ai_addrlen) == 0)
+			break;
+		::close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(result);
+
+	// Messages are small and latency matters more than throughput
+	if(fd >= 0)
+	{
+		int yes = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+	}
+	return Socket(fd);
+}
+
+Socket Socket::accept()
+{
+	int new_fd = ::accept(fd, nullptr, nullptr);
+	if(new_fd >= 0)
+	{
+		int yes = 1;
+		setsockopt(new_fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+	}
+	return Socket(new_fd);
+}
+
+bool Socket::send_message(const std::string& message)
+{
+	// Header: the length of the message, then a newline
+	std::stringstream s;
+	s<<message.size()<<'\n'<<message;
+	return send_text(s.str());
+}
+
+bool Socket::send_text(const std::string& text)
+{
+	size_t sent = 0;
+	while(sent < text.size())
+	{
+		ssize_t n = ::send(fd, text.data() + sent, text.size() - sent,
+							MSG_NOSIGNAL);
+		if(n <= 0)
+			return false;
+		sent += n;
+	}
+	return true;
+}
+
+bool Socket::receive_text(std::string& text, size_t max)
+{
+	text.resize(max);
+	ssize_t n = ::recv(fd, &text[0], max, 0);
+	if(n <= 0)
+	{
+		text.clear();
+		return false;
+	}
+	text.resize(n);
+	return true;
+}
+
+bool Socket::wait_readable(int milliseconds)
+{
+	pollfd p;
+	p.fd = fd;
+	p.events = POLLIN;
+	p.revents = 0;
+	return ::poll(&p, 1, milliseconds) > 0;
+}
+
+bool Socket::take_message(std::string& message)
+{
+	size_t newline = pending.find('\n');
+	if(newline == std::string::npos)
+		return false;
+
+	size_t size = std::strtoul(pending.c_str(), NULL, 10);
+	if(pending.size() - newline - 1 < size)
+		return false;
+
+	message = pending.substr(newline + 1, size);
+	pending.erase(0, newline + 1 + size);
+	return true;
+}
+
+bool Socket::receive_message(std::string& message)
+{
+	char buffer[4096];
+	while(!take_message(message))
+	{
+		ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+		if(n <= 0)
+			return false;
+		pending.append(buffer, n);
+	}
+	return true;
+}
+
+bool Socket::receive_available(std::string& message, bool& complete)
+{
+	char buffer[4096];
+	while(true)
+	{
+		ssize_t n = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if(n > 0)
+		{
+			pending.append(buffer, n);
+			continue;
+		}
+		if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if(n < 0 && errno == EINTR)
+			continue;
+		return false;
+	}
+
+	// A header that long is garbage, not a partial message
+	if(pending.find('\n') == std::string::npos && pending.size() > 32)
+		return false;
+
+	complete = take_message(message);
+	return true;
+}
+
+void Socket::close()
+{
+	if(fd >= 0)
+		::close(fd);
+	fd = -1;
+}
+
+#else
+
+Socket Socket::listen(const std::string&, unsigned short)
+{
+	throw std::runtime_error("sockets are not supported on this platform.");
+}
+
+Socket Socket::listen_local(const std::string&)
+{
+	return Socket();
+}
+
+Socket Socket::connect(const std::string&, unsigned short)
+{
+	return Socket();
+}
+
+Socket Socket::accept()
+{
+	return Socket();
+}
+
+bool Socket::send_message(const std::string&)
+{
+	return false;
+}
+
+bool Socket::receive_message(std::string&)
+{
+	return false;
+}
+
+bool Socket::receive_available(std::string&, bool& complete)
+{
+	complete = false;
+	return false;
+}
+
+bool Socket::send_text(const std::string&)
+{
+	return false;
+}
+
+bool Socket::receive_text(std::string& text, size_t)
+{
+	text.clear();
+	return false;
+}
+
+bool Socket::wait_readable(int)
+{
+	return false;
+}
+
+void Socket::close()
+{
+	fd = -1;
+}
+
+#endif
+
+bool parse_address(const std::string& address, std::string& host,
+					unsigned short& port)
+{
+	size_t colon = address.rfind(':');
+	host = (colon == std::string::npos)?("localhost"):(address.substr(0, colon));
+	std::string port_str = (colon == std::string::npos)?(address):(address.substr(colon + 1));
+
+	char* end = nullptr;
+	unsigned long p = std::strtoul(port_str.c_str(), &end, 10);
+	if(port_str.size() == 0 || *end != '\0' || p == 0 || p > 65535)
+		return false;
+	port = static_cast<unsigned short>(p);
+	return true;
+}
+
+bool remove_socket_file(const std::string& path)
+{
+#ifndef _WIN32
+	struct stat info;
+	if(::lstat(path.c_str(), &info) != 0 || !S_ISSOCK(info.st_mode))
+		return false;
+	return ::unlink(path.c_str()) == 0;
+#else
+	(void)path;
+	return false;
+#endif
+}
+
+} // namespace DNest4
+
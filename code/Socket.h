@@ -0,0 +1,91 @@
+#ifndef DNest4_Socket
+#define DNest4_Socket
+
+#include <string>
+
+namespace DNest4
+{
+
+/*
+* A TCP socket carrying length-prefixed text messages.
+* Used to share levels between processes (see Coordinator), and to
+* serve metrics to local scrapers (see MetricsServer).
+*/
+class Socket
+{
+	private:
+		int fd;
+
+		// What has arrived but isn't yet a whole message
+		std::string pending;
+
+		// Take the first whole message out of 'pending', if there is one
+		bool take_message(std::string& message);
+
+	public:
+		// An unconnected socket
+		Socket();
+
+		// Take ownership of an open file descriptor
+		explicit Socket(int fd);
+
+		~Socket();
+
+		Socket(const Socket& other) = delete;
+		Socket& operator = (const Socket& other) = delete;
+		Socket(Socket&& other);
+		Socket& operator = (Socket&& other);
+
+		// Listen on the given port of the interface 'host' resolves to
+		// (e.g. "localhost", or "0.0.0.0" for all interfaces)
+		static Socket listen(const std::string& host, unsigned short port);
+
+		// Listen on this machine only: on a loopback port if 'address'
+		// is a port (or localhost:port), otherwise on a Unix socket at
+		// that path. Returns an unconnected socket on failure, including
+		// for a host:port whose host isn't local and for a path where
+		// something other than a socket already is.
+		static Socket listen_local(const std::string& address);
+
+		// Connect to host:port. Returns an unconnected socket on failure.
+		static Socket connect(const std::string& host, unsigned short port);
+
+		// Accept a pending connection on a listening socket
+		Socket accept();
+
+		// Send or receive a whole message. False if the connection is lost.
+		bool send_message(const std::string& message);
+		bool receive_message(std::string& message);
+
+		// Read whatever has arrived without blocking. 'complete' says
+		// whether that finished a message, which is then put in 'message'.
+		// False if the connection is lost.
+		bool receive_available(std::string& message, bool& complete);
+
+		// Send raw text, or receive whatever has arrived (up to 'max'
+		// bytes), for talking to things that aren't DNest4
+		bool send_text(const std::string& text);
+		bool receive_text(std::string& text, size_t max=4096);
+
+		// Wait up to 'milliseconds' for something to accept or receive
+		bool wait_readable(int milliseconds);
+
+		void close();
+
+		bool is_open() const
+		{ return fd >= 0; }
+		int get_fd() const
+		{ return fd; }
+};
+
+// Split "host:port" (or just "port") into its parts
+bool parse_address(const std::string& address, std::string& host,
+					unsigned short& port);
+
+// Delete the file at 'path' if it is a Unix socket (and nothing else)
+bool remove_socket_file(const std::string& path);
+
+} // namespace DNest4
+
+#endif
+
@@ -17,6 +17,11 @@ Sampler<ModelType> setup(int argc, char** argv);
 template<class ModelType>
 Sampler<ModelType> setup(const CommandLineOptions& options, bool load_checkpoint=false);
 
+// As above, with particles starting as copies of 'prototype'
+template<class ModelType>
+Sampler<ModelType> setup(const CommandLineOptions& options,
+						const ModelType& prototype, bool load_checkpoint=false);
+
 template<class ModelType>
 void start(int argc, char** argv);
 
@@ -1,5 +1,6 @@
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include "CommandLineOptions.h"
 #include "RNG.h"
 #include "Sampler.h"
@@ -18,23 +19,80 @@ Sampler<ModelType> setup(int argc, char** argv)
 template<class ModelType>
 Sampler<ModelType> setup(const CommandLineOptions& options, bool load_checkpoint)
 {
-	std::cout<<"# Using "<<options.get_num_threads()<<" thread"<<
-		((options.get_num_threads() == 1)?("."):("s."))<<std::endl;
+	return setup<ModelType>(options, ModelType(), load_checkpoint);
+}
 
-	std::cout<<"# Target compression factor between levels = ";
-	std::cout<<options.get_compression()<<std::endl;
+template<class ModelType>
+Sampler<ModelType> setup(const CommandLineOptions& options,
+						const ModelType& prototype, bool load_checkpoint)
+{
+	// Checkpoint and stop if the process is asked to terminate. setup()
+	// is for a program's one sampler, which owns the process; samplers
+	// embedded elsewhere (e.g. Batch jobs) don't install the handler.
+	install_drain_handler(options.get_drain_deadline());
 
 	// Load sampler options from file
 	Options sampler_options(options.get_options_file().c_str());
 
+	// The optimiser creates levels for as long as it runs
+	if(options.get_optimiser_top_k() > 0)
+		sampler_options.max_num_levels = std::numeric_limits<unsigned int>::max();
+
 	// Create sampler
 	Sampler<ModelType> sampler(options.get_num_threads(),
 								options.get_compression_double(),
 								sampler_options,
-								true, options.get_adaptive());
+								true, options.get_adaptive(), prototype);
+
+	if(options.get_log_file() != "")
+		sampler.get_logger().add_file(options.get_log_file());
+	sampler.get_logger().info()<<"# Using "<<options.get_num_threads()<<" thread"<<
+		((options.get_num_threads() == 1)?("."):("s."));
+	sampler.get_logger().info()<<"# Target compression factor between levels = "
+		<<options.get_compression();
+
+	if(options.get_optimiser_top_k() > 0)
+		sampler.set_optimiser_mode(options.get_optimiser_top_k());
+	if(options.get_galilean_probability() > 0.)
+		sampler.set_galilean_moves(options.get_galilean_probability());
+	if(options.get_slice_probability() > 0.)
+		sampler.set_slice_moves(options.get_slice_probability());
+	if(options.get_ensemble_probability() > 0.)
+		sampler.set_ensemble_moves(options.get_ensemble_probability());
+	if(options.get_num_pool_workers() >= 0)
+		sampler.use_thread_pool(options.get_num_pool_workers());
+	if(options.get_profile_file() != "")
+		sampler.set_profiling(true, options.get_profile_file());
+	if(options.get_trace_file() != "")
+		sampler.set_tracing(true, options.get_trace_file());
+	if(options.get_metrics_file() != "" || options.get_metrics_address() != "")
+		sampler.set_metrics(options.get_metrics_file(),
+							options.get_metrics_address());
+	if(options.get_num_tries() > 1)
+		sampler.set_multiple_tries(options.get_num_tries());
+	if(options.get_delayed_acceptance())
+		sampler.set_delayed_acceptance(true);
+	if(options.get_proposal_target() > 0.)
+		sampler.set_proposal_scaling(options.get_proposal_target());
+	if(options.get_thread_steps_overhead() > 0.)
+		sampler.set_thread_steps_tuning(0.01*options.get_thread_steps_overhead());
 
 	// Seed RNGs
-	sampler.initialise(0, load_checkpoint);
+	sampler.initialise(options.get_seed_uint(), load_checkpoint);
+
+	// Adopt the levels of a previous run
+	if(!load_checkpoint && options.get_warm_start_file() != "")
+		sampler.warm_start(options.get_warm_start_file(),
+							options.get_warm_start_thin(),
+							options.get_warm_start_respace());
+
+	// Share levels with other processes
+	if(options.get_coordinator_address() != "")
+		sampler.connect_to_coordinator(options.get_coordinator_address());
+
+	sampler.set_stopping_rules(options.get_stopping_rules());
+	if(options.get_control_file() != "")
+		sampler.set_control_file(options.get_control_file());
 
 	return sampler;
 }
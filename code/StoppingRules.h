@@ -0,0 +1,47 @@
+#ifndef DNest4_StoppingRules
+#define DNest4_StoppingRules
+
+namespace DNest4
+{
+
+/*
+* Reasons to end a run before max_num_saves is reached. They are checked
+* during bookkeeping, and whichever is met first stops the sampler after
+* a final checkpoint. A value of zero switches a rule off.
+*/
+struct StoppingRules
+{
+	// Wall-clock time (in seconds) spent in run()
+	double max_run_time;
+
+	// Likelihood evaluations done by this process
+	unsigned long long int max_num_likelihood_evaluations;
+
+	// Once all levels exist, stop when the estimate of log(Z) has stayed
+	// within log_Z_tolerance over the last log_Z_window estimates. An
+	// estimate is made each time the saves have grown by 1% (or by one,
+	// early on).
+	double log_Z_tolerance;
+	unsigned int log_Z_window;
+
+	// Once all levels exist, stop when the effective sample size of the
+	// saved particles reaches this value
+	double target_ess;
+
+	StoppingRules()
+	:max_run_time(0.)
+	,max_num_likelihood_evaluations(0)
+	,log_Z_tolerance(0.)
+	,log_Z_window(10)
+	,target_ess(0.)
+	{ }
+
+	// Do any rules need the log(Z) and ESS estimates?
+	bool need_estimates() const
+	{ return log_Z_tolerance > 0. || target_ess > 0.; }
+};
+
+} // namespace DNest4
+
+#endif
+
@@ -4,11 +4,15 @@
 
 int main(int argc, char** argv)
 {
+    // Set up sampler
+    DNest4::CommandLineOptions options(argc, argv);
+    DNest4::Sampler<MyModel> sampler = DNest4::setup<MyModel>(options);
+
     // Use randh2
-    DNest4::RNG::randh_is_randh2 = true;
+    sampler.set_randh_is_randh2(true);
 
     // Run sampler
-	DNest4::start<MyModel>(argc, argv);
+    sampler.run();
 
 	return 0;
 }
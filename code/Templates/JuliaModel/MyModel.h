@@ -19,6 +19,13 @@ class MyModel
 		// Metropolis-Hastings proposals
 		double perturb(DNest4::RNG& rng);
 
+		// The parameters are already unit hypercube coordinates,
+		// which lets the sampler use slice moves
+		void get_coordinates(std::vector<double>& u) const
+		{ u = x; }
+		void set_coordinates(const std::vector<double>& u)
+		{ x = u; }
+
 		// Likelihood function
 		double log_likelihood() const;
 
@@ -0,0 +1,90 @@
+#include "NormalModel.h"
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+using namespace DNest4;
+
+NormalModel::NormalModel()
+{
+	x.fill(0.);
+	x_proposed = x;
+}
+
+double NormalModel::log_likelihood_of(const std::array<double, 4>& x)
+{
+	double total = -0.5*x.size()*log(2.*M_PI);
+	for(double xi: x)
+		total += -0.5*xi*xi;
+	return total;
+}
+
+void NormalModel::from_prior(size_t i)
+{
+	RNG rng(i);
+	for(double& xi: x)
+		xi = -10. + 20.*rng.rand();
+	x_proposed = x;
+}
+
+double NormalModel::perturb(RNG& rng)
+{
+	x_proposed = x;
+	double& xi = x_proposed[rng.rand_int(x.size())];
+	xi += 20.*rng.randh();
+	wrap(xi, -10., 10.);
+	return 0.;
+}
+
+void NormalModel::accept_perturbation()
+{
+	x = x_proposed;
+}
+
+double NormalModel::log_likelihood() const
+{
+	return log_likelihood_of(x);
+}
+
+double NormalModel::proposal_log_likelihood() const
+{
+	return log_likelihood_of(x_proposed);
+}
+
+void NormalModel::print(std::ostream& out) const
+{
+	for(double xi: x)
+		out<<xi<<' ';
+}
+
+// Checkpoints are written in hexfloat, which operator>> can't read
+void NormalModel::read(std::istream& in)
+{
+	std::string s;
+	for(double& xi: x)
+	{
+		in>>s;
+		xi = std::strtod(s.c_str(), NULL);
+	}
+}
+
+void NormalModel::print_internal(std::ostream& out) const
+{
+	for(double xi: x_proposed)
+		out<<xi<<' ';
+}
+
+void NormalModel::read_internal(std::istream& in)
+{
+	std::string s;
+	for(double& xi: x_proposed)
+	{
+		in>>s;
+		xi = std::strtod(s.c_str(), NULL);
+	}
+}
+
+std::string NormalModel::description() const
+{
+	return "x[0], x[1], x[2], x[3]";
+}
@@ -0,0 +1,36 @@
+#ifndef DNest4_Tests_NormalModel
+#define DNest4_Tests_NormalModel
+
+#include "DNest4/code/DNest4.h"
+#include <array>
+#include <ostream>
+
+/*
+* A standard normal likelihood in four dimensions with a uniform prior on
+* [-10, 10] in each, so log(Z) = -4 log(20) to within rounding.
+*/
+class NormalModel
+{
+	private:
+		std::array<double, 4> x, x_proposed;
+
+		static double log_likelihood_of(const std::array<double, 4>& x);
+
+	public:
+		NormalModel();
+
+		void from_prior(size_t i);
+		double perturb(DNest4::RNG& rng);
+		void accept_perturbation();
+
+		double log_likelihood() const;
+		double proposal_log_likelihood() const;
+
+		void print(std::ostream& out) const;
+		void read(std::istream& in);
+		void print_internal(std::ostream& out) const;
+		void read_internal(std::istream& in);
+		std::string description() const;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "DNest4/code/DNest4.h"
+#include "NormalModel.h"
+
+using namespace DNest4;
+
+// Port the test coordinator listens on
+const unsigned short port = 47561;
+
+// Run a sampler with the given seed, writing its output to 'directory'
+// and sharing levels through the test coordinator if 'shared'
+void run(const Options& options, const std::string& directory,
+			unsigned int seed, bool shared)
+{
+	Options run_options = options;
+	run_options.prefix_filenames(directory + "/");
+
+	Sampler<NormalModel> sampler(1, exp(1.), run_options, true, false);
+	sampler.get_logger().set_level(LogLevel::off);
+	sampler.initialise(seed);
+	if(shared)
+		sampler.connect_to_coordinator("localhost:" + std::to_string(port));
+	sampler.run();
+}
+
+std::string read_file(const std::string& filename)
+{
+	std::fstream fin(filename, std::ios::in);
+	return std::string(std::istreambuf_iterator<char>(fin),
+						std::istreambuf_iterator<char>());
+}
+
+/*
+* Two workers sharing levels through a coordinator on this machine, and
+* a solo run of the same model. Exits with status 1 if the workers give
+* the same samples, or if their merged log(Z) is out of line with the
+* solo run's.
+*/
+int main()
+{
+	Options options(5, 1000, 100, 100, 25, 10., 100., 2000, false);
+	const std::vector<std::string> directories{"coordinator_test_solo",
+						"coordinator_test_worker1", "coordinator_test_worker2",
+						"coordinator_test_coordinator"};
+	for(const std::string& directory: directories)
+		mkdir(directory.c_str(), 0755);
+
+	run(options, directories[0], 0, false);
+
+	Options coordinator_options = options;
+	coordinator_options.prefix_filenames(directories[3] + "/");
+	Coordinator coordinator("localhost", port, exp(1.), coordinator_options);
+	coordinator.get_logger().set_level(LogLevel::off);
+	std::thread coordinator_thread(&Coordinator::run, &coordinator);
+	std::thread worker1(run, options, directories[1], 1, true);
+	std::thread worker2(run, options, directories[2], 2, true);
+	worker1.join();
+	worker2.join();
+	coordinator_thread.join();
+
+	RunMerger solo({directories[0]});
+	solo.merge();
+	RunMerger workers({directories[1], directories[2]});
+	workers.merge();
+
+	// The workers draw their own particles and samples
+	bool distinct = read_file(directories[1] + "/sample.txt") !=
+					read_file(directories[2] + "/sample.txt");
+
+	// log(Z) agrees to within a few times the scatter between runs
+	bool consistent = std::abs(workers.get_log_Z() - solo.get_log_Z()) < 0.5;
+
+	for(const std::string& directory: directories)
+	{
+		Options run_options = options;
+		run_options.prefix_filenames(directory + "/");
+		for(const std::string& filename: {run_options.sample_file,
+						run_options.sample_info_file, run_options.levels_file,
+						run_options.checkpoint_file,
+						run_options.best_particle_file,
+						run_options.best_likelihood_file})
+			std::remove(filename.c_str());
+		rmdir(directory.c_str());
+	}
+
+	std::cout << "# Solo log(Z) = " << solo.get_log_Z()
+		<< ", two workers log(Z) = " << workers.get_log_Z() << "." << std::endl;
+	if(!distinct || !consistent)
+	{
+		std::cerr << "# Workers sharing a coordinator: FAILED"
+			<< ((distinct)?(""):(" (identical samples)")) << "." << std::endl;
+		return 1;
+	}
+	std::cout << "# Workers sharing a coordinator: passed." << std::endl;
+	return 0;
+}
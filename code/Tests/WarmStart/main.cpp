@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DNest4/code/DNest4.h"
+#include "Data.h"
+#include "StraightLine.h"
+
+using namespace DNest4;
+
+/*
+* Warm-start a sampler from another's checkpoint, for a model whose
+* particles share a dataset (so a default-constructed particle can't
+* read one). Exits with status 1 if the levels aren't adopted.
+*/
+int main()
+{
+	std::vector<double> x(100), y(100);
+	RNG rng(0);
+	for(size_t i=0; i<x.size(); ++i)
+	{
+		x[i] = 10.*i/x.size();
+		y[i] = 3.*x[i] + 1. + rng.randn();
+	}
+	auto data = std::make_shared<const Data>(x, y);
+
+	Options options(5, 1000, 1000, 100, 10, 10., 100., 50, false);
+	options.prefix_filenames("warm_start_test_");
+
+	// A short run, leaving a checkpoint
+	Sampler<StraightLine> first(2, exp(1.), options, true, false,
+								StraightLine(data));
+	first.get_logger().set_level(LogLevel::off);
+	first.initialise(0);
+	first.run();
+
+	// A new sampler adopting its levels
+	Sampler<StraightLine> second(2, exp(1.), options, true, false,
+								StraightLine(data));
+	second.get_logger().set_level(LogLevel::off);
+	second.initialise(1);
+	second.warm_start(options.checkpoint_file);
+
+	bool passed = first.get_levels().size() > 1 &&
+			second.get_levels().size() == first.get_levels().size();
+	for(size_t i=0; passed && i<first.get_levels().size(); ++i)
+		passed = !(first.get_levels()[i].get_log_likelihood() <
+					second.get_levels()[i].get_log_likelihood()) &&
+				!(second.get_levels()[i].get_log_likelihood() <
+					first.get_levels()[i].get_log_likelihood());
+
+	for(const std::string& filename: {options.sample_file,
+					options.sample_info_file, options.levels_file,
+					options.checkpoint_file, options.best_particle_file,
+					options.best_likelihood_file})
+		std::remove(filename.c_str());
+
+	if(!passed)
+	{
+		std::cerr << "# Warm start from a checkpoint: FAILED." << std::endl;
+		return 1;
+	}
+	std::cout << "# Warm start from a checkpoint: passed." << std::endl;
+	return 0;
+}
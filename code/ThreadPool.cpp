@@ -0,0 +1,176 @@
+#include "ThreadPool.h"
+
+namespace DNest4
+{
+
+namespace
+{
+	thread_local ThreadPool* current_pool = nullptr;
+}
+
+ThreadPool* ThreadPool::current()
+{
+	return current_pool;
+}
+
+void ThreadPool::set_current(ThreadPool* pool)
+{
+	current_pool = pool;
+}
+
+ThreadPool::ThreadPool(unsigned int num_workers)
+:num_queued(0)
+,num_pending(0)
+,next_queue(0)
+,stopping(false)
+{
+	if(num_workers == 0)
+		num_workers = 1;
+
+	for(unsigned int i=0; i<num_workers; ++i)
+		queues.emplace_back(new TaskQueue);
+	for(unsigned int i=0; i<num_workers; ++i)
+		workers.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(the_mutex);
+		stopping = true;
+	}
+	cond.notify_all();
+	for(auto& w: workers)
+		w.join();
+}
+
+int ThreadPool::own_queue() const
+{
+	std::thread::id id = std::this_thread::get_id();
+	for(size_t i=0; i<workers.size(); ++i)
+		if(workers[i].get_id() == id)
+			return static_cast<int>(i);
+	return -1;
+}
+
+void ThreadPool::submit(const std::function<void()>& task)
+{
+	int which = own_queue();
+	{
+		std::lock_guard<std::mutex> lock(the_mutex);
+		if(which < 0)
+			which = (next_queue++) % queues.size();
+		++num_pending;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queues[which]->the_mutex);
+		queues[which]->tasks.push_back(task);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(the_mutex);
+		++num_queued;
+	}
+	cond.notify_one();
+}
+
+std::function<void()> ThreadPool::take_task(unsigned int which)
+{
+	// The caller has claimed a task, so one is guaranteed to turn up
+	while(true)
+	{
+		// Newest task from our own queue
+		{
+			TaskQueue& q = *queues[which];
+			std::lock_guard<std::mutex> lock(q.the_mutex);
+			if(!q.tasks.empty())
+			{
+				std::function<void()> task = q.tasks.back();
+				q.tasks.pop_back();
+				return task;
+			}
+		}
+
+		// Oldest task from someone else's
+		for(size_t k=1; k<queues.size(); ++k)
+		{
+			TaskQueue& q = *queues[(which + k) % queues.size()];
+			std::lock_guard<std::mutex> lock(q.the_mutex);
+			if(!q.tasks.empty())
+			{
+				std::function<void()> task = q.tasks.front();
+				q.tasks.pop_front();
+				return task;
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+void ThreadPool::run_task(unsigned int which)
+{
+	std::function<void()> task = take_task(which);
+	task();
+
+	std::lock_guard<std::mutex> lock(the_mutex);
+	if(--num_pending == 0)
+		done_cond.notify_all();
+}
+
+void ThreadPool::worker(unsigned int which)
+{
+	current_pool = this;
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(the_mutex);
+			cond.wait(lock, [this] { return stopping || num_queued > 0; });
+			if(num_queued == 0)
+				return;
+			--num_queued;
+		}
+		run_task(which);
+	}
+}
+
+bool ThreadPool::run_pending_task()
+{
+	int which = own_queue();
+	{
+		std::lock_guard<std::mutex> lock(the_mutex);
+		if(num_queued == 0)
+			return false;
+		--num_queued;
+	}
+	run_task((which < 0) ? (0) : (which));
+	return true;
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& task)
+{
+	if(n == 0)
+		return;
+
+	std::atomic<size_t> remaining(n);
+	for(size_t i=1; i<n; ++i)
+		submit([&task, &remaining, i] { task(i); --remaining; });
+	task(0);
+	--remaining;
+
+	while(remaining > 0)
+		if(!run_pending_task())
+			std::this_thread::yield();
+}
+
+void ThreadPool::wait(bool help)
+{
+	while(help && run_pending_task())
+		;
+
+	std::unique_lock<std::mutex> lock(the_mutex);
+	done_cond.wait(lock, [this] { return num_pending == 0; });
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,112 @@
+#ifndef DNest4_ThreadPool
+#define DNest4_ThreadPool
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DNest4
+{
+
+/*
+* A fixed set of worker threads, each with its own queue of tasks.
+* Idle workers steal from the other queues, so long and short tasks
+* balance out across the pool.
+*/
+class ThreadPool
+{
+	private:
+		// A worker's queue of tasks
+		struct TaskQueue
+		{
+			std::mutex the_mutex;
+			std::deque< std::function<void()> > tasks;
+		};
+
+		std::vector<std::thread> workers;
+		std::vector< std::unique_ptr<TaskQueue> > queues;
+
+		// Tasks queued but not yet claimed, and not yet finished
+		std::mutex the_mutex;
+		std::condition_variable cond;
+		std::condition_variable done_cond;
+		unsigned int num_queued;
+		unsigned int num_pending;
+		unsigned int next_queue;
+		bool stopping;
+
+		// Which queue belongs to the calling thread (or -1)
+		int own_queue() const;
+
+		// Take a task, trying 'which' first then stealing
+		std::function<void()> take_task(unsigned int which);
+
+		// Claim, run and retire one queued task
+		void run_task(unsigned int which);
+
+		// Loop run by each worker
+		void worker(unsigned int which);
+
+	public:
+		// Constructor: launch the workers
+		explicit ThreadPool(unsigned int num_workers);
+
+		// Destructor: finish queued tasks and join the workers
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool& operator = (const ThreadPool& other) = delete;
+
+		// Queue a task. Tasks submitted from a worker go to its own queue.
+		void submit(const std::function<void()>& task);
+
+		// Run one queued task on the calling thread, if there is one
+		bool run_pending_task();
+
+		// Run task(0), ..., task(n-1) on the pool and the calling thread,
+		// returning once they have all finished. The caller helps out with
+		// queued tasks (its own or anyone's) while it waits, so this can
+		// be called from inside a task.
+		void parallel_for(size_t n, const std::function<void(size_t)>& task);
+
+		// Block until every submitted task has finished, helping out
+		// with queued tasks in the meantime unless 'help' is false
+		void wait(bool help=true);
+
+		unsigned int size() const
+		{ return workers.size(); }
+
+		// The pool that parallel work started on the calling thread
+		// should use (see Parallel.h). Workers use their own pool.
+		static ThreadPool* current();
+		static void set_current(ThreadPool* pool);
+
+		// Makes a pool (if not null) current on the calling thread
+		// for the lifetime of the object
+		class Using
+		{
+			private:
+				ThreadPool* previous;
+
+			public:
+				explicit Using(ThreadPool* pool)
+				:previous(current())
+				{ if(pool != nullptr) set_current(pool); }
+
+				~Using()
+				{ set_current(previous); }
+
+				Using(const Using& other) = delete;
+				Using& operator = (const Using& other) = delete;
+		};
+};
+
+} // namespace DNest4
+
+#endif
+
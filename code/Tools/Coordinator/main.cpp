@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include "DNest4/code/DNest4.h"
+
+using namespace std;
+using namespace DNest4;
+
+/*
+* Coordinator for sharing levels between sampler processes.
+* Usage: main -r [<host>:]<port> [-o OPTIONS] [-c compression] [-l logfile]
+* Then start workers with -r <host>:<port>.
+* Without a host it listens on this machine only. Workers aren't
+* authenticated, so only listen on other interfaces (e.g. -r 0.0.0.0:port)
+* on a trusted network.
+*/
+int main(int argc, char** argv)
+{
+	CommandLineOptions options(argc, argv);
+	Options sampler_options(options.get_options_file().c_str());
+
+	string host;
+	unsigned short port;
+	if(!parse_address(options.get_coordinator_address(), host, port))
+	{
+		cerr<<"# ERROR: Specify the port to listen on with -r [<host>:]<port>."<<endl;
+		return 1;
+	}
+
+	Coordinator coordinator(host, port, options.get_compression_double(),
+							sampler_options);
+	if(options.get_log_file() != "")
+		coordinator.get_logger().add_file(options.get_log_file());
+	coordinator.run();
+
+	return 0;
+}
+
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "DNest4/code/DNest4.h"
+
+using namespace std;
+using namespace DNest4;
+
+/*
+* Merge the output of independent runs of the same model.
+* Usage: main [-c cut] [-r resample] [-s seed] run_dir1 run_dir2 ...
+* Writes merged_levels.txt, weights.txt and posterior_sample.txt.
+*/
+int main(int argc, char** argv)
+{
+	double cut = 0.;
+	double resample = 1.;
+	unsigned int seed = 0;
+
+	int c;
+	while((c = getopt(argc, argv, "c:r:s:")) != -1)
+	{
+		switch(c)
+		{
+			case 'c': stringstream(optarg)>>cut; break;
+			case 'r': stringstream(optarg)>>resample; break;
+			case 's': stringstream(optarg)>>seed; break;
+			default:
+				cerr<<"Usage: "<<argv[0];
+				cerr<<" [-c cut] [-r resample] [-s seed] run_dir ..."<<endl;
+				return 1;
+		}
+	}
+
+	vector<string> directories(argv + optind, argv + argc);
+	if(directories.size() == 0)
+	{
+		cerr<<"# ERROR: No run directories given."<<endl;
+		return 1;
+	}
+
+	RunMerger merger(directories, cut);
+	merger.merge();
+	merger.print_stats(cout);
+
+	RNG rng(seed);
+	merger.save_levels("merged_levels.txt");
+	merger.save_weights("weights.txt");
+	merger.save_posterior_sample("posterior_sample.txt", rng, resample);
+
+	return 0;
+}
+
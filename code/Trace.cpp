@@ -0,0 +1,102 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <limits>
+
+namespace DNest4
+{
+
+TraceBuffer::TraceBuffer(size_t capacity)
+:events(capacity)
+,count(0)
+{
+	assert(capacity > 0);
+}
+
+TraceBuffer::TraceBuffer(const TraceBuffer& other)
+:events(other.events)
+,count(other.count.load(std::memory_order_acquire))
+{
+
+}
+
+TraceBuffer& TraceBuffer::operator = (const TraceBuffer& other)
+{
+	count.store(other.count.load(std::memory_order_acquire),
+				std::memory_order_relaxed);
+	events = other.events;
+	return *this;
+}
+
+void TraceBuffer::record(const char* name,
+						std::chrono::steady_clock::time_point start,
+						std::chrono::steady_clock::time_point end)
+{
+	using std::chrono::duration_cast;
+	using std::chrono::nanoseconds;
+
+	unsigned long long int n = count.load(std::memory_order_relaxed);
+	TraceEvent& event = events[n % events.size()];
+	event.name = name;
+	event.start = duration_cast<nanoseconds>(start.time_since_epoch()).count();
+	event.duration = duration_cast<nanoseconds>(end - start).count();
+	count.store(n + 1, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceBuffer::get_events() const
+{
+	unsigned long long int n = count.load(std::memory_order_acquire);
+	unsigned long long int first = (n > events.size())?(n - events.size()):(0);
+
+	std::vector<TraceEvent> result;
+	result.reserve(n - first);
+	for(unsigned long long int i=first; i<n; ++i)
+		result.push_back(events[i % events.size()]);
+	return result;
+}
+
+unsigned long long int TraceBuffer::get_num_dropped() const
+{
+	unsigned long long int n = count.load(std::memory_order_acquire);
+	return (n > events.size())?(n - events.size()):(0);
+}
+
+void write_chrome_trace(std::ostream& out,
+						const std::vector<TraceBuffer>& buffers)
+{
+	std::vector< std::vector<TraceEvent> > events;
+	long long int origin = std::numeric_limits<long long int>::max();
+	for(const auto& buffer: buffers)
+	{
+		events.push_back(buffer.get_events());
+		for(const auto& event: events.back())
+			origin = std::min(origin, event.start);
+	}
+
+	// Times are in microseconds, from the earliest event
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+	bool first = true;
+	for(size_t i=0; i<events.size(); ++i)
+	{
+		out << ((first)?(""):(",\n"));
+		out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, ";
+		out << "\"tid\": " << i << ", \"args\": {\"name\": \"thread " << i;
+		out << "\", \"dropped_events\": " << buffers[i].get_num_dropped();
+		out << "}}";
+		first = false;
+
+		for(const auto& event: events[i])
+		{
+			out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", ";
+			out << "\"pid\": 0, \"tid\": " << i << ", ";
+			out << "\"ts\": " << 1E-3*(event.start - origin) << ", ";
+			out << "\"dur\": " << 1E-3*event.duration << "}";
+		}
+	}
+	out << std::endl << "]}" << std::endl;
+}
+
+} // namespace DNest4
+
@@ -0,0 +1,105 @@
+#ifndef DNest4_Trace
+#define DNest4_Trace
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+namespace DNest4
+{
+
+/*
+* A timeline of what each thread was doing, for finding stragglers that
+* the totals in Profiler.h hide. Each thread records complete events
+* (name, start and duration) into its own ring buffer, keeping the most
+* recent ones. Only the owning thread writes to a buffer, and the count
+* of events is published with release/acquire ordering, so recording
+* takes no locks. Read the buffers while their threads are waiting
+* (e.g. during bookkeeping) or after the run. The result can be written
+* in the Chrome trace format, which chrome://tracing and Perfetto open.
+* Compiling with -DNO_TRACING removes the scopes altogether.
+*/
+struct TraceEvent
+{
+	// Must be a string literal (it is not copied)
+	const char* name;
+
+	// Nanoseconds on the steady clock
+	long long int start;
+	long long int duration;
+};
+
+class TraceBuffer
+{
+	private:
+		std::vector<TraceEvent> events;
+
+		// Events ever recorded (the slot of the next one is this modulo
+		// the capacity)
+		std::atomic<unsigned long long int> count;
+
+	public:
+		explicit TraceBuffer(size_t capacity=65536);
+		TraceBuffer(const TraceBuffer& other);
+		TraceBuffer& operator = (const TraceBuffer& other);
+
+		// Only called by the thread that owns the buffer
+		void record(const char* name,
+					std::chrono::steady_clock::time_point start,
+					std::chrono::steady_clock::time_point end);
+
+		// The events still held, oldest first
+		std::vector<TraceEvent> get_events() const;
+
+		// Events overwritten because the buffer was full
+		unsigned long long int get_num_dropped() const;
+};
+
+// Records an event from construction to destruction, if given a buffer
+class TraceScope
+{
+	private:
+		TraceBuffer* buffer;
+		const char* name;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		TraceScope(TraceBuffer* buffer, const char* name)
+		:buffer(buffer)
+		,name(name)
+		{
+			if(buffer != nullptr)
+				start = std::chrono::steady_clock::now();
+		}
+
+		~TraceScope()
+		{
+			if(buffer != nullptr)
+				buffer->record(name, start, std::chrono::steady_clock::now());
+		}
+
+		TraceScope(const TraceScope& other) = delete;
+		TraceScope& operator = (const TraceScope& other) = delete;
+};
+
+// Write the buffers (one per thread, numbered in order) as a Chrome trace
+void write_chrome_trace(std::ostream& out,
+						const std::vector<TraceBuffer>& buffers);
+
+} // namespace DNest4
+
+// Record the rest of the enclosing scope as an event called 'name' (a
+// string literal) in 'buffer' (a TraceBuffer*, or nullptr to skip)
+#ifndef NO_TRACING
+	#define DNEST4_TRACE_JOIN2(a, b) a##b
+	#define DNEST4_TRACE_JOIN(a, b) DNEST4_TRACE_JOIN2(a, b)
+	#define DNEST4_TRACE(buffer, name) \
+		DNest4::TraceScope DNEST4_TRACE_JOIN(trace_scope_, __LINE__)( \
+														(buffer), (name))
+#else
+	#define DNEST4_TRACE(buffer, name)
+#endif
+
+#endif
+
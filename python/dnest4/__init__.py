@@ -11,11 +11,13 @@ if not __DNEST4_SETUP__:
     __all__ = [
         "DNest4Sampler",
         "postprocess",
+        "merge_runs",
         "analysis",
         "my_loadtxt, loadtxt_rows",
     ]
 
     from . import analysis
+    from .analysis import merge_runs
     from .sampler import DNest4Sampler
     from .deprecated import postprocess, postprocess_abc
     from .loading import my_loadtxt, loadtxt_rows
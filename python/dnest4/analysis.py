@@ -11,7 +11,7 @@ except NameError:
 else:
     stringtype = basestring
 
-__all__ = ["postprocess", "make_plots"]
+__all__ = ["postprocess", "merge_runs", "make_plots"]
 
 
 def postprocess(backend=None,
@@ -108,6 +108,144 @@ def postprocess(backend=None,
     return stats
 
 
+def merge_runs(backends, cut=0, resample=0, output=None):
+    """
+    Combine independent runs of the same model into a single result.
+
+    The level ladders are aligned into one (each threshold's log(X) is the
+    average over the runs that span it), the samples of all runs are pooled
+    and placed between the merged levels, and log(Z) is computed from the
+    pooled samples. The scatter of the per-run log(Z) values gives the
+    between-run uncertainty.
+
+    :param backends:
+        A list of backends or output directories, one per run.
+
+    :param cut: (optional)
+        Fraction of each run's samples to discard as burn-in.
+
+    :param resample: (optional)
+        If non-zero, draw ``resample * N_eff`` posterior samples.
+
+    :param output: (optional)
+        A backend or directory to write the merged levels, weights,
+        posterior samples and stats to.
+
+    """
+    backends = [CSVBackend(b) if isinstance(b, stringtype) else b
+                for b in backends]
+    if not len(backends):
+        raise ValueError("no runs to merge")
+
+    # Load every run and compute its own log(Z).
+    ladders, samples, sample_info, run_log_z = [], [], [], []
+    for backend in backends:
+        levels = backend.levels
+        s, info = backend.samples, backend.sample_info
+        if len(info.shape) > 1:
+            s, info = subsample_particles(s, info)
+        n = min(len(s), len(info))
+        s, info = s[:n], info[:n]
+        if cut > 0:
+            s, info = remove_burnin(s, info, cut)
+
+        log_X = sandwich_log_X(levels, info)
+        run_log_z.append(compute_stats(levels, info, log_X)[0])
+        ladders.append(levels)
+        samples.append(s)
+        sample_info.append(info)
+
+    levels = merge_ladders(ladders)
+    samples = np.concatenate(samples, axis=0)
+    sample_info = np.concatenate(sample_info)
+
+    # The pooled samples on the merged ladder.
+    log_X = sandwich_log_X(levels, sample_info)
+    log_z, h, n_eff, log_post = compute_stats(levels, sample_info, log_X)
+
+    run_log_z = np.array(run_log_z)
+    log_z_std = np.std(run_log_z, ddof=1) if len(run_log_z) > 1 else 0.0
+    stats = dict(
+        log_Z=log_z, log_Z_std=log_z_std,
+        log_Z_err=log_z_std / np.sqrt(len(run_log_z)),
+        H=h, N_eff=n_eff, num_runs=len(run_log_z),
+    )
+
+    if output is not None:
+        if isinstance(output, stringtype):
+            output = CSVBackend(output)
+        output.write_levels(levels)
+        output.write_weights(np.exp(log_post))
+        if resample:
+            output.write_posterior_samples(generate_posterior_samples(
+                samples, log_post, int(resample * n_eff)
+            ))
+        output.write_stats(stats)
+
+    stats["run_log_Z"] = run_log_z
+    return stats
+
+
+def merge_ladders(ladders):
+    # Pool the thresholds of all runs (level 0 is the prior, shared by all).
+    levels = np.concatenate([ladders[0][:1]] + [l[1:] for l in ladders])
+    inds = np.lexsort((levels["tiebreaker"][1:], levels["log_likelihood"][1:]))
+    levels = np.concatenate((levels[:1], levels[1:][inds]))
+
+    # Each run's log(X) at every threshold it spans (NaN elsewhere).
+    log_l = levels["log_likelihood"][1:]
+    x = np.array([
+        np.interp(log_l, l["log_likelihood"][1:], l["log_X"][1:],
+                  left=np.nan, right=np.nan)
+        for l in ladders if len(l) > 1
+    ])
+
+    # Average the decrements in log(X) between neighbouring thresholds over
+    # the runs spanning both; this stays monotonic as runs drop in and out.
+    # Where no run spans both, fall back to the difference of the means.
+    mean = np.nanmean(x, axis=0)
+    d = np.diff(x, axis=1)
+    m = np.isfinite(d)
+    num = m.sum(axis=0)
+    fallback = np.minimum(np.diff(mean), 0.0)
+    step = np.where(num > 0, np.where(m, d, 0.0).sum(axis=0)
+                    / np.maximum(num, 1), fallback)
+    levels["log_X"][0] = 0.0
+    if len(mean):
+        levels["log_X"][1:] = mean[0] + np.append(0.0, np.cumsum(step))
+    return levels
+
+
+def sandwich_log_X(levels, sample_info):
+    # A vectorised version of interpolate_samples. Samples are assigned to
+    # the highest level they exceed (levels win exact ties) and placed
+    # uniformly in X, in order of likelihood, within their level.
+    n_lev, n_samp = len(levels), len(sample_info)
+    log_l = np.append(levels["log_likelihood"], sample_info["log_likelihood"])
+    tb = np.append(levels["tiebreaker"], sample_info["tiebreaker"])
+    is_samp = np.append(np.zeros(n_lev, dtype=bool),
+                        np.ones(n_samp, dtype=bool))
+    order = np.lexsort((is_samp, tb, log_l))
+
+    level_ind = np.where(is_samp[order], 0, order)
+    level_ind = np.maximum.accumulate(level_ind)
+    samp = is_samp[order]
+    sample_ids = order[samp] - n_lev
+    assign = np.empty(n_samp, dtype=int)
+    assign[sample_ids] = level_ind[samp]
+
+    # Position of each sample within its level, in order of likelihood.
+    count = np.bincount(assign, minlength=n_lev)
+    first = np.cumsum(count) - count
+    pos = np.empty(n_samp, dtype=int)
+    pos[sample_ids] = np.arange(n_samp) - first[level_ind[samp]]
+
+    x_min = np.exp(np.append(levels["log_X"][1:], -np.inf))
+    x_max = np.exp(levels["log_X"])
+    n = (count[assign] - pos) / (count[assign] + 1.0)
+    return np.log(x_min[assign] + (x_max - x_min)[assign] * n)
+
+
 def logsumexp(x, axis=None):
     mx = np.max(x, axis=axis)
     return np.log(np.sum(np.exp(x - mx), axis=axis)) + mx